@@ -0,0 +1,3172 @@
+/*
+ * ajou_native: 아주대 공지 페이지용 네이티브 헬퍼
+ *
+ * scan_notices(html: bytes) -> list[tuple]
+ *     notice.do 목록 HTML 을 DOM 없이 한 번만 훑어서
+ *     (id, title, date, writer, href, category) 튜플 목록을 돌려준다.
+ *     selectolax 의 css() 쿼리와 같은 규칙을 따른다.
+ *         id       td.b-num-box            text(strip=True)
+ *         title    div.b-title-box > a     text(strip=True)
+ *         href     div.b-title-box > a     attributes["href"]
+ *         date     span.b-date             text(strip=True)
+ *         writer   span.b-writer           text(strip=False)
+ *         category span.b-cate             text(strip=True)
+ *     td.b-no-post 가 있으면 빈 목록.
+ *
+ * json_field(text: str, limit=0, strip=None) -> bytes
+ *     "[strip]" 을 지우고 (지웠으면 앞뒤 공백도), limit 글자를 넘으면
+ *     limit-2 글자 + ".." 로 자른 뒤 JSON 문자열(따옴표 포함)로 escape 한다.
+ *     글자 수는 UTF-8 코드포인트 기준이라 한글을 중간에 자르지 않는다.
+ *
+ * build_card(title, date, link, writer, put_date=False) -> bytes
+ *     Ktemplate.buildCard 의 리스트 카드 한 개.
+ *     (title 35자, description 16자, 카카오 ListCard 제한)
+ *
+ * scan_batch(html: bytes, address: str) -> NoticeBatch
+ *     scan_notices 와 같이 훑지만 행마다 튜플/str 을 만들지 않고 arena 하나에 담는다.
+ *     title 의 "[writer]" 는 지우고, link 는 address + href.
+ *     len(batch), batch.id(i) (int) / day(i) / title / date / writer / link,
+ *     batch.row(i), batch.leading(day), batch.to_cards(stop=-1, put_date=False),
+ *     memoryview(batch)[start:end] (batch.span(i, "title"))
+ *
+ * batch.dump() -> bytes / load_batch(data) -> NoticeBatch
+ *     다시 훑지 않고 열 배열을 그대로 옮긴다. (publisher -> pre-fork 워커)
+ *
+ * to_day(text: str) -> int
+ *     "21.03.01" 같은 날짜 -> date.toordinal(), 모르는 형식은 0
+ *
+ * skim_skill(body: bytes) -> (user_id, params, utterance) | None
+ *     카카오 스킬 payload 에서 userRequest.user.id, userRequest.utterance,
+ *     action.params 만 꺼낸다. 나머지 값은 dict 를 만들지 않고 건너뛴다.
+ *     없는 값은 None (params 는 {}). params 에 문자열이 아닌 값이 있으면
+ *     None 을 돌려주고 (호출한 쪽이 json.loads 로 처리), JSON 이 깨졌으면 ValueError.
+ *
+ * Server(host="0.0.0.0", port=8000, backlog=1024, max_body=65536)  (Linux)
+ *     epoll HTTP/1.1 front-end. serve_forever() 는 GIL 없이 돌면서
+ *     publish({key: (bodies, track)}) 로 받은 응답 표에 있는 POST 는 바로 보낸다.
+ *     key 는 경로, params 가 문자열 하나면 "경로?name=value" (/message?when=today).
+ *     표에 없거나 params 가 여러 개 / escape 가 있는 요청, Origin 이 있는 요청은
+ *     next() 로 Python 에 넘기고 reply(token, response) 를 기다린다.
+ *     track 인 경로로 온 user.id 는 drain_users() 로 꺼낸다.
+ *     reuse_port 면 SO_REUSEPORT 로 여러 프로세스가 같은 포트를 연다.
+ *
+ * snapshot_write(shm, payload) -> seq
+ * snapshot_read(shm, last_seq=0) -> (seq, payload) | None  (Linux)
+ * snapshot_reset(shm) -> seq  (Linux)
+ *     fork 전에 만든 공유 mmap 에 writer 하나가 쓰고 여러 프로세스가 lock 없이 읽는다.
+ *     (seqlock) 읽을 때 seq 가 last_seq 그대로면 None.
+ */
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+/* ---------------------------------------------------------------- buffer */
+
+typedef struct {
+    char *data;
+    Py_ssize_t len;
+    Py_ssize_t cap;
+} Buf;
+
+static int
+buf_reserve(Buf *b, Py_ssize_t extra)
+{
+    Py_ssize_t need = b->len + extra;
+    if (need <= b->cap)
+        return 0;
+    Py_ssize_t cap = b->cap ? b->cap : 64;
+    while (cap < need)
+        cap *= 2;
+    char *p = PyMem_Realloc(b->data, (size_t)cap);
+    if (p == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    b->data = p;
+    b->cap = cap;
+    return 0;
+}
+
+static int
+buf_put(Buf *b, const char *s, Py_ssize_t n)
+{
+    if (n == 0)
+        return 0;
+    if (buf_reserve(b, n) < 0)
+        return -1;
+    memcpy(b->data + b->len, s, (size_t)n);
+    b->len += n;
+    return 0;
+}
+
+static void
+buf_free(Buf *b)
+{
+    PyMem_Free(b->data);
+    b->data = NULL;
+    b->len = b->cap = 0;
+}
+
+/* ---------------------------------------------------------- html helpers */
+
+static int
+is_space(unsigned char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+static int
+lower(unsigned char c)
+{
+    return (c >= 'A' && c <= 'Z') ? c + 32 : c;
+}
+
+static int
+ieq(const char *s, Py_ssize_t n, const char *lit)
+{
+    Py_ssize_t i = 0;
+    for (; i < n && lit[i]; i++)
+        if (lower((unsigned char)s[i]) != lit[i])
+            return 0;
+    return i == n && lit[i] == '\0';
+}
+
+static int
+put_utf8(Buf *b, unsigned long cp)
+{
+    char tmp[4];
+    Py_ssize_t n;
+    if (cp == 0 || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+        cp = 0xFFFD;
+    if (cp < 0x80) {
+        tmp[0] = (char)cp;
+        n = 1;
+    }
+    else if (cp < 0x800) {
+        tmp[0] = (char)(0xC0 | (cp >> 6));
+        tmp[1] = (char)(0x80 | (cp & 0x3F));
+        n = 2;
+    }
+    else if (cp < 0x10000) {
+        tmp[0] = (char)(0xE0 | (cp >> 12));
+        tmp[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        tmp[2] = (char)(0x80 | (cp & 0x3F));
+        n = 3;
+    }
+    else {
+        tmp[0] = (char)(0xF0 | (cp >> 18));
+        tmp[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+        tmp[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        tmp[3] = (char)(0x80 | (cp & 0x3F));
+        n = 4;
+    }
+    return buf_put(b, tmp, n);
+}
+
+static const struct {
+    const char *name;
+    unsigned long cp;
+} ENTITIES[] = {
+    {"amp", '&'}, {"lt", '<'},     {"gt", '>'},     {"quot", '"'},
+    {"apos", '\''}, {"nbsp", 0xA0}, {"middot", 0xB7}, {NULL, 0},
+};
+
+/* s[0] == '&' 인 엔티티 하나를 풀어 넣고 소비한 길이를 돌려준다. 모르면 0. */
+static Py_ssize_t
+decode_entity(Buf *out, const char *s, Py_ssize_t n)
+{
+    Py_ssize_t i = 1;
+    unsigned long cp = 0;
+
+    if (n > 2 && s[1] == '#') {
+        int hex = (s[2] == 'x' || s[2] == 'X');
+        i = hex ? 3 : 2;
+        Py_ssize_t start = i;
+        for (; i < n && i < start + 8; i++) {
+            unsigned char c = (unsigned char)s[i];
+            if (c >= '0' && c <= '9')
+                cp = cp * (hex ? 16 : 10) + (c - '0');
+            else if (hex && lower(c) >= 'a' && lower(c) <= 'f')
+                cp = cp * 16 + (lower(c) - 'a' + 10);
+            else
+                break;
+        }
+        if (i == start)
+            return 0;
+        if (i < n && s[i] == ';')
+            i++;
+        return put_utf8(out, cp) < 0 ? -1 : i;
+    }
+
+    while (i < n && i < 10 && ((s[i] >= 'a' && s[i] <= 'z') || (s[i] >= 'A' && s[i] <= 'Z')))
+        i++;
+    for (int k = 0; ENTITIES[k].name; k++) {
+        if ((Py_ssize_t)strlen(ENTITIES[k].name) == i - 1 &&
+            memcmp(ENTITIES[k].name, s + 1, (size_t)(i - 1)) == 0) {
+            if (i < n && s[i] == ';')
+                i++;
+            return put_utf8(out, ENTITIES[k].cp) < 0 ? -1 : i;
+        }
+    }
+    return 0;
+}
+
+/* 텍스트 노드 하나를 (엔티티를 풀어서) out 에 붙인다. strip 이면 앞뒤 공백 제거. */
+static int
+put_text(Buf *out, const char *s, Py_ssize_t n, int strip)
+{
+    if (strip) {
+        while (n > 0 && is_space((unsigned char)s[0])) {
+            s++;
+            n--;
+        }
+        while (n > 0 && is_space((unsigned char)s[n - 1]))
+            n--;
+    }
+    Py_ssize_t i = 0, run = 0;
+    while (i < n) {
+        if (s[i] == '&') {
+            if (buf_put(out, s + run, i - run) < 0)
+                return -1;
+            Py_ssize_t used = decode_entity(out, s + i, n - i);
+            if (used < 0)
+                return -1;
+            if (used == 0) {
+                if (buf_put(out, "&", 1) < 0)
+                    return -1;
+                used = 1;
+            }
+            i += used;
+            run = i;
+        }
+        else {
+            i++;
+        }
+    }
+    return buf_put(out, s + run, n - run);
+}
+
+/* ------------------------------------------------------------- tokenizer */
+
+typedef struct {
+    const char *name;
+    Py_ssize_t name_len;
+    const char *cls; /* class 속성 값 (raw) */
+    Py_ssize_t cls_len;
+    const char *href; /* href 속성 값 (raw) */
+    Py_ssize_t href_len;
+    int closing;
+} Tag;
+
+/* s[pos] == '<' 에서 태그를 읽는다. 다음 위치를 돌려주고, 태그가 아니면 -1. */
+static Py_ssize_t
+read_tag(const char *s, Py_ssize_t n, Py_ssize_t pos, Tag *tag)
+{
+    Py_ssize_t i = pos + 1;
+    memset(tag, 0, sizeof(*tag));
+
+    if (i < n && s[i] == '/') {
+        tag->closing = 1;
+        i++;
+    }
+    if (i >= n || lower((unsigned char)s[i]) < 'a' || lower((unsigned char)s[i]) > 'z')
+        return -1;
+    Py_ssize_t start = i;
+    while (i < n && !is_space((unsigned char)s[i]) && s[i] != '>' && s[i] != '/')
+        i++;
+    tag->name = s + start;
+    tag->name_len = i - start;
+
+    while (i < n && s[i] != '>') {
+        if (is_space((unsigned char)s[i]) || s[i] == '/') {
+            i++;
+            continue;
+        }
+        Py_ssize_t an = i;
+        while (i < n && !is_space((unsigned char)s[i]) && s[i] != '=' && s[i] != '>')
+            i++;
+        Py_ssize_t an_len = i - an;
+        while (i < n && is_space((unsigned char)s[i]))
+            i++;
+        const char *val = NULL;
+        Py_ssize_t val_len = 0;
+        if (i < n && s[i] == '=') {
+            i++;
+            while (i < n && is_space((unsigned char)s[i]))
+                i++;
+            if (i < n && (s[i] == '"' || s[i] == '\'')) {
+                char q = s[i++];
+                val = s + i;
+                while (i < n && s[i] != q)
+                    i++;
+                val_len = (s + i) - val;
+                if (i < n)
+                    i++;
+            }
+            else {
+                val = s + i;
+                while (i < n && !is_space((unsigned char)s[i]) && s[i] != '>')
+                    i++;
+                val_len = (s + i) - val;
+            }
+        }
+        if (ieq(s + an, an_len, "class")) {
+            tag->cls = val;
+            tag->cls_len = val_len;
+        }
+        else if (ieq(s + an, an_len, "href")) {
+            tag->href = val;
+            tag->href_len = val_len;
+        }
+    }
+    return i < n ? i + 1 : n;
+}
+
+static int
+same_name(const Tag *a, const Tag *b)
+{
+    if (a->name_len != b->name_len)
+        return 0;
+    for (Py_ssize_t i = 0; i < a->name_len; i++)
+        if (lower((unsigned char)a->name[i]) != lower((unsigned char)b->name[i]))
+            return 0;
+    return 1;
+}
+
+static int
+has_class(const Tag *tag, const char *want)
+{
+    Py_ssize_t wl = (Py_ssize_t)strlen(want);
+    const char *c = tag->cls;
+    Py_ssize_t n = tag->cls_len, i = 0;
+    while (i < n) {
+        while (i < n && is_space((unsigned char)c[i]))
+            i++;
+        Py_ssize_t st = i;
+        while (i < n && !is_space((unsigned char)c[i]))
+            i++;
+        if (i - st == wl && memcmp(c + st, want, (size_t)wl) == 0)
+            return 1;
+    }
+    return 0;
+}
+
+/* 주석/선언/raw text 블록을 건너뛴 위치. 해당 없으면 pos 그대로. */
+static Py_ssize_t
+skip_special(const char *s, Py_ssize_t n, Py_ssize_t pos)
+{
+    if (pos + 3 < n && memcmp(s + pos, "<!--", 4) == 0) {
+        const char *end = NULL;
+        for (Py_ssize_t i = pos + 4; i + 2 < n; i++)
+            if (s[i] == '-' && s[i + 1] == '-' && s[i + 2] == '>') {
+                end = s + i + 3;
+                break;
+            }
+        return end ? end - s : n;
+    }
+    if (pos + 1 < n && (s[pos + 1] == '!' || s[pos + 1] == '?')) {
+        const char *gt = memchr(s + pos, '>', (size_t)(n - pos));
+        return gt ? gt - s + 1 : n;
+    }
+    return pos;
+}
+
+/*
+ * pos (여는 태그 바로 뒤) 부터 같은 이름의 닫는 태그까지 텍스트를 모은다.
+ * 안쪽 태그는 버리고 텍스트 노드만 이어붙인다. 닫는 태그 뒤 위치를 돌려준다.
+ */
+static Py_ssize_t
+collect_text(const char *s, Py_ssize_t n, Py_ssize_t pos, const Tag *open, Buf *out, int strip)
+{
+    int depth = 1;
+    Py_ssize_t text_start = pos;
+    Py_ssize_t i = pos;
+
+    while (i < n) {
+        const char *lt = memchr(s + i, '<', (size_t)(n - i));
+        if (lt == NULL)
+            break;
+        Py_ssize_t at = lt - s;
+        if (put_text(out, s + text_start, at - text_start, strip) < 0)
+            return -1;
+
+        Py_ssize_t next = skip_special(s, n, at);
+        if (next != at) {
+            i = text_start = next;
+            continue;
+        }
+        Tag t;
+        next = read_tag(s, n, at, &t);
+        if (next < 0) {
+            /* 태그가 아닌 '<' 는 텍스트 */
+            if (put_text(out, "<", 1, 0) < 0)
+                return -1;
+            i = text_start = at + 1;
+            continue;
+        }
+        if (same_name(&t, open)) {
+            depth += t.closing ? -1 : 1;
+            if (depth == 0)
+                return next;
+        }
+        i = text_start = next;
+    }
+    if (put_text(out, s + text_start, n - text_start, strip) < 0)
+        return -1;
+    return n;
+}
+
+/* ------------------------------------------------------------------ scan */
+
+enum { F_ID, F_TITLE, F_DATE, F_WRITER, F_HREF, F_CATE, F_COUNT };
+
+typedef struct {
+    Buf field[F_COUNT];
+    int open;
+} Row;
+
+static void
+row_reset(Row *row)
+{
+    for (int k = 0; k < F_COUNT; k++)
+        row->field[k].len = 0;
+    row->open = 0;
+}
+
+typedef int (*RowSink)(Row *row, void *ctx);
+
+static int
+row_flush(Row *row, RowSink sink, void *ctx)
+{
+    if (!row->open)
+        return 0;
+    int rc = sink(row, ctx);
+    row_reset(row);
+    return rc;
+}
+
+/* html 을 훑으며 행마다 sink 를 부른다. 0 = 끝, 1 = td.b-no-post, -1 = 오류 */
+static int
+scan_rows(const char *s, Py_ssize_t n, RowSink sink, void *ctx)
+{
+    Row row;
+    memset(&row, 0, sizeof(row));
+    int title_box = 0; /* div.b-title-box 안에서 아직 a 를 못 찾았으면 div 깊이 */
+    int rc = -1;
+    Py_ssize_t i = 0;
+
+    while (i < n) {
+        const char *lt = memchr(s + i, '<', (size_t)(n - i));
+        if (lt == NULL)
+            break;
+        Py_ssize_t at = lt - s;
+        Py_ssize_t next = skip_special(s, n, at);
+        if (next != at) {
+            i = next;
+            continue;
+        }
+        Tag t;
+        next = read_tag(s, n, at, &t);
+        if (next < 0) {
+            i = at + 1;
+            continue;
+        }
+        i = next;
+
+        if (t.closing) {
+            if (title_box && ieq(t.name, t.name_len, "div"))
+                title_box--;
+            continue;
+        }
+        if (ieq(t.name, t.name_len, "script") || ieq(t.name, t.name_len, "style")) {
+            /* raw text: 닫는 태그까지 통째로 건너뛴다 */
+            Buf skip = {0};
+            i = collect_text(s, n, i, &t, &skip, 0);
+            buf_free(&skip);
+            if (i < 0)
+                goto done;
+            continue;
+        }
+
+        if (ieq(t.name, t.name_len, "div")) {
+            if (title_box)
+                title_box++;
+            else if (t.cls && has_class(&t, "b-title-box"))
+                title_box = 1;
+            continue;
+        }
+        if (t.cls == NULL && !(title_box == 1 && ieq(t.name, t.name_len, "a")))
+            continue;
+
+        Buf *dst = NULL;
+        int strip = 1;
+        if (ieq(t.name, t.name_len, "td")) {
+            if (has_class(&t, "b-no-post")) {
+                rc = 1;
+                goto done;
+            }
+            if (has_class(&t, "b-num-box")) {
+                if (row_flush(&row, sink, ctx) < 0)
+                    goto done;
+                row.open = 1;
+                dst = &row.field[F_ID];
+            }
+        }
+        else if (title_box == 1 && ieq(t.name, t.name_len, "a")) {
+            title_box = 0;
+            row.field[F_TITLE].len = row.field[F_HREF].len = 0;
+            if (t.href && put_text(&row.field[F_HREF], t.href, t.href_len, 0) < 0)
+                goto done;
+            dst = &row.field[F_TITLE];
+        }
+        else if (ieq(t.name, t.name_len, "span")) {
+            if (has_class(&t, "b-date"))
+                dst = &row.field[F_DATE];
+            else if (has_class(&t, "b-writer")) {
+                dst = &row.field[F_WRITER];
+                strip = 0;
+            }
+            else if (has_class(&t, "b-cate"))
+                dst = &row.field[F_CATE];
+        }
+        if (dst == NULL)
+            continue;
+
+        dst->len = 0;
+        i = collect_text(s, n, i, &t, dst, strip);
+        if (i < 0)
+            goto done;
+    }
+    rc = row_flush(&row, sink, ctx);
+
+done:
+    for (int k = 0; k < F_COUNT; k++)
+        buf_free(&row.field[k]);
+    return rc;
+}
+
+static int
+tuple_sink(Row *row, void *ctx)
+{
+    PyObject *tup = PyTuple_New(F_COUNT);
+    if (tup == NULL)
+        return -1;
+    for (int k = 0; k < F_COUNT; k++) {
+        PyObject *v = PyUnicode_DecodeUTF8(row->field[k].data ? row->field[k].data : "",
+                                           row->field[k].len, "replace");
+        if (v == NULL) {
+            Py_DECREF(tup);
+            return -1;
+        }
+        PyTuple_SET_ITEM(tup, k, v);
+    }
+    int rc = PyList_Append((PyObject *)ctx, tup);
+    Py_DECREF(tup);
+    return rc;
+}
+
+static PyObject *
+scan_notices(PyObject *Py_UNUSED(self), PyObject *arg)
+{
+    Py_buffer view;
+    if (PyObject_GetBuffer(arg, &view, PyBUF_SIMPLE) < 0)
+        return NULL;
+
+    PyObject *rows = PyList_New(0);
+    if (rows != NULL) {
+        int rc = scan_rows(view.buf, view.len, tuple_sink, rows);
+        if (rc < 0)
+            Py_CLEAR(rows);
+        else if (rc == 1)
+            Py_SETREF(rows, PyList_New(0));
+    }
+    PyBuffer_Release(&view);
+    return rows;
+}
+
+/* ----------------------------------------------------------- card kernel */
+
+#define TITLE_LIMIT 35
+#define DESCRIPTION_LIMIT 16
+
+static int
+is_lead(unsigned char c)
+{
+    return (c & 0xC0) != 0x80;
+}
+
+/*
+ * s 에서 pattern 을 모두 지운다. 지웠으면 결과를 clean 에 만들고 앞뒤 공백도 자른다.
+ * (title.replace("[writer]", "").strip()) *out 은 s 또는 clean 안을 가리킨다.
+ */
+static int
+strip_pattern(const char *s, Py_ssize_t n, const char *pattern, Py_ssize_t pattern_len,
+              Buf *clean, const char **out, Py_ssize_t *out_len)
+{
+    *out = s;
+    *out_len = n;
+    if (pattern_len <= 0 || n < pattern_len)
+        return 0;
+
+    Py_ssize_t i = 0, run = 0;
+    int removed = 0;
+    while (i + pattern_len <= n) {
+        if (s[i] == pattern[0] && memcmp(s + i, pattern, (size_t)pattern_len) == 0) {
+            if (buf_put(clean, s + run, i - run) < 0)
+                return -1;
+            i += pattern_len;
+            run = i;
+            removed = 1;
+        }
+        else {
+            i++;
+        }
+    }
+    if (!removed)
+        return 0;
+    if (buf_put(clean, s + run, n - run) < 0)
+        return -1;
+
+    const char *src = clean->data ? clean->data : "";
+    Py_ssize_t len = clean->len;
+    while (len > 0 && is_space((unsigned char)src[0])) {
+        src++;
+        len--;
+    }
+    while (len > 0 && is_space((unsigned char)src[len - 1]))
+        len--;
+    *out = src;
+    *out_len = len;
+    return 0;
+}
+
+/*
+ * s 에서 pattern 을 모두 지우고(지웠으면 앞뒤 공백 제거) limit 으로 자른 결과를
+ * JSON 문자열로 out 에 쓴다.
+ */
+static int
+put_field(Buf *out, const char *s, Py_ssize_t n, Py_ssize_t limit,
+          const char *pattern, Py_ssize_t pattern_len)
+{
+    static const char hex[] = "0123456789abcdef";
+    Buf clean = {0};
+    const char *src;
+    Py_ssize_t len;
+    int rc = -1;
+
+    /* 1) "[writer]" 제거 */
+    if (strip_pattern(s, n, pattern, pattern_len, &clean, &src, &len) < 0)
+        goto done;
+
+    /* 2) 글자 수를 세면서 limit-2 번째 글자가 시작하는 위치를 기억 */
+    Py_ssize_t cut = len, chars = 0;
+    int truncated = 0;
+    if (limit > 2) {
+        for (Py_ssize_t i = 0; i < len; i++) {
+            if (!is_lead((unsigned char)src[i]))
+                continue;
+            if (chars == limit - 2)
+                cut = i;
+            if (++chars > limit) {
+                truncated = 1;
+                break;
+            }
+        }
+    }
+    if (!truncated)
+        cut = len;
+
+    /* 3) escape (json.encoder.encode_basestring 과 같은 규칙) */
+    if (buf_reserve(out, cut + 4) < 0 || buf_put(out, "\"", 1) < 0)
+        goto done;
+    Py_ssize_t run = 0;
+    for (Py_ssize_t i = 0; i < cut; i++) {
+        unsigned char c = (unsigned char)src[i];
+        const char *esc = NULL;
+        char u[6];
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+        switch (c) {
+        case '"': esc = "\\\""; break;
+        case '\\': esc = "\\\\"; break;
+        case '\n': esc = "\\n"; break;
+        case '\r': esc = "\\r"; break;
+        case '\t': esc = "\\t"; break;
+        case '\b': esc = "\\b"; break;
+        case '\f': esc = "\\f"; break;
+        default:
+            memcpy(u, "\\u00", 4);
+            u[4] = hex[c >> 4];
+            u[5] = hex[c & 0xF];
+        }
+        if (buf_put(out, src + run, i - run) < 0)
+            goto done;
+        if ((esc ? buf_put(out, esc, 2) : buf_put(out, u, 6)) < 0)
+            goto done;
+        run = i + 1;
+    }
+    if (buf_put(out, src + run, cut - run) < 0)
+        goto done;
+    if (truncated && buf_put(out, "..", 2) < 0)
+        goto done;
+    rc = buf_put(out, "\"", 1);
+
+done:
+    buf_free(&clean);
+    return rc;
+}
+
+static PyObject *
+buf_to_bytes(Buf *b)
+{
+    PyObject *res = PyBytes_FromStringAndSize(b->data ? b->data : "", b->len);
+    buf_free(b);
+    return res;
+}
+
+static PyObject *
+json_field(PyObject *Py_UNUSED(self), PyObject *args, PyObject *kwargs)
+{
+    static char *kwlist[] = {"text", "limit", "strip", NULL};
+    const char *text, *strip = NULL;
+    Py_ssize_t text_len, strip_len = 0, limit = 0;
+    Buf out = {0};
+    Buf pattern = {0};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s#|nz#", kwlist, &text, &text_len,
+                                     &limit, &strip, &strip_len))
+        return NULL;
+    if (strip != NULL &&
+        (buf_put(&pattern, "[", 1) < 0 || buf_put(&pattern, strip, strip_len) < 0 ||
+         buf_put(&pattern, "]", 1) < 0))
+        goto fail;
+    if (put_field(&out, text, text_len, limit, pattern.data, pattern.len) < 0)
+        goto fail;
+    buf_free(&pattern);
+    return buf_to_bytes(&out);
+
+fail:
+    buf_free(&pattern);
+    buf_free(&out);
+    return NULL;
+}
+
+/* 같은 규칙으로 카드 한 개 전체를 만든다. */
+static int
+put_card(Buf *out, const char *title, Py_ssize_t title_len, const char *date,
+         Py_ssize_t date_len, const char *link, Py_ssize_t link_len, const char *writer,
+         Py_ssize_t writer_len, int put_date)
+{
+    Buf tmp = {0};
+    int rc = -1;
+
+    if (buf_reserve(&tmp, writer_len + 2) < 0)
+        goto done;
+    tmp.data[0] = '[';
+    memcpy(tmp.data + 1, writer, (size_t)writer_len);
+    tmp.data[writer_len + 1] = ']';
+    tmp.len = writer_len + 2;
+
+    if (buf_put(out, "{\"title\":", 9) < 0 ||
+        put_field(out, title, title_len, TITLE_LIMIT, tmp.data, tmp.len) < 0 ||
+        buf_put(out, ",\"description\":", 15) < 0)
+        goto done;
+
+    tmp.len = 0;
+    if (buf_put(&tmp, writer, writer_len) < 0)
+        goto done;
+    if (put_date) {
+        /* postDate[len(postDate) - 5:] */
+        Py_ssize_t start = date_len, chars = 0;
+        while (start > 0 && chars < 5) {
+            start--;
+            if (is_lead((unsigned char)date[start]))
+                chars++;
+        }
+        if (buf_put(&tmp, " ", 1) < 0 || buf_put(&tmp, date + start, date_len - start) < 0)
+            goto done;
+    }
+    if (put_field(out, tmp.data ? tmp.data : "", tmp.len, DESCRIPTION_LIMIT, NULL, 0) < 0 ||
+        buf_put(out, ",\"link\":{\"web\":", 15) < 0 ||
+        put_field(out, link, link_len, 0, NULL, 0) < 0 || buf_put(out, "}}", 2) < 0)
+        goto done;
+    rc = 0;
+
+done:
+    buf_free(&tmp);
+    return rc;
+}
+
+static PyObject *
+build_card(PyObject *Py_UNUSED(self), PyObject *args, PyObject *kwargs)
+{
+    static char *kwlist[] = {"title", "date", "link", "writer", "put_date", NULL};
+    const char *title, *date, *link, *writer;
+    Py_ssize_t title_len, date_len, link_len, writer_len;
+    int put_date = 0;
+    Buf out = {0};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s#s#s#s#|p", kwlist, &title, &title_len,
+                                     &date, &date_len, &link, &link_len, &writer,
+                                     &writer_len, &put_date))
+        return NULL;
+    if (put_card(&out, title, title_len, date, date_len, link, link_len, writer, writer_len,
+                 put_date) < 0) {
+        buf_free(&out);
+        return NULL;
+    }
+    return buf_to_bytes(&out);
+}
+
+/* ----------------------------------------------------------- notice batch */
+
+/*
+ * NoticeBatch: 공지 목록 한 페이지를 Python 객체 없이 들고 있는다.
+ * 모든 문자열은 arena 하나에 이어 붙이고, 열(column)마다 [start, end) 배열을 둔다.
+ * id 와 날짜는 파싱할 때 정수로 바꿔 따로 둔다. (id: 고정 공지는 0,
+ * day: date.toordinal(), 모르는 형식은 0)
+ * str 은 접근할 때만 만들고, to_cards() 는 arena 에서 바로 카드 JSON 을 쓴다.
+ */
+enum { B_TITLE, B_DATE, B_WRITER, B_LINK, B_COUNT };
+
+static const char *const B_NAMES[B_COUNT] = {"title", "date", "writer", "link"};
+
+typedef struct {
+    Py_ssize_t start;
+    Py_ssize_t end;
+} Span;
+
+typedef struct {
+    PyObject_HEAD
+    char *arena;
+    Py_ssize_t arena_len;
+    Span *column[B_COUNT]; /* column[k][i] */
+    long long *id;
+    int *day;
+    Py_ssize_t count;
+} NoticeBatch;
+
+static PyTypeObject NoticeBatchType;
+
+/* 올바른 UTF-8 인가 (overlong / surrogate / 0x10FFFF 초과 X) */
+static int
+utf8_valid(const unsigned char *s, Py_ssize_t n)
+{
+    Py_ssize_t i = 0;
+    while (i < n) {
+        unsigned char c = s[i];
+        if (c < 0x80) {
+            i++;
+            continue;
+        }
+        int need;
+        unsigned long cp;
+        if (c >= 0xC2 && c <= 0xDF) {
+            need = 1;
+            cp = c & 0x1F;
+        }
+        else if (c >= 0xE0 && c <= 0xEF) {
+            need = 2;
+            cp = c & 0x0F;
+        }
+        else if (c >= 0xF0 && c <= 0xF4) {
+            need = 3;
+            cp = c & 0x07;
+        }
+        else {
+            return 0;
+        }
+        if (i + need >= n)
+            return 0;
+        for (int k = 1; k <= need; k++) {
+            if ((s[i + k] & 0xC0) != 0x80)
+                return 0;
+            cp = (cp << 6) | (s[i + k] & 0x3F);
+        }
+        if ((need == 2 && (cp < 0x800 || (cp >= 0xD800 && cp <= 0xDFFF))) ||
+            (need == 3 && (cp < 0x10000 || cp > 0x10FFFF)))
+            return 0;
+        i += need + 1;
+    }
+    return 1;
+}
+
+/* 앞뒤 공백을 뺀 숫자만의 문자열 -> 정수, 아니면 0 ("공지") */
+static long long
+parse_id(const char *s, Py_ssize_t n)
+{
+    long long v = 0;
+    Py_ssize_t i = 0, digits = 0;
+    while (i < n && is_space((unsigned char)s[i]))
+        i++;
+    for (; i < n && s[i] >= '0' && s[i] <= '9' && digits < 18; i++, digits++)
+        v = v * 10 + (s[i] - '0');
+    while (i < n && is_space((unsigned char)s[i]))
+        i++;
+    return (digits > 0 && i == n) ? v : 0;
+}
+
+static int
+read_number(const char *s, Py_ssize_t n, Py_ssize_t *i, int max_digits, int *out)
+{
+    int v = 0, digits = 0;
+    while (*i < n && s[*i] >= '0' && s[*i] <= '9' && digits < max_digits) {
+        v = v * 10 + (s[*i] - '0');
+        (*i)++;
+        digits++;
+    }
+    *out = v;
+    return digits;
+}
+
+/*
+ * "21.03.01" / "2021.03.01" / "2021-03-01" -> date(...).toordinal(), 아니면 0
+ * 두 자리 연도는 2000 년대로 본다.
+ */
+static int
+parse_day(const char *s, Py_ssize_t n)
+{
+    static const int days_in[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    static const int before[12] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+    Py_ssize_t i = 0;
+    int y, m, d, yd;
+
+    while (i < n && is_space((unsigned char)s[i]))
+        i++;
+    if ((yd = read_number(s, n, &i, 4, &y)) == 0 || i >= n || !strchr("./-", s[i]))
+        return 0;
+    i++;
+    if (read_number(s, n, &i, 2, &m) == 0 || i >= n || !strchr("./-", s[i]))
+        return 0;
+    i++;
+    if (read_number(s, n, &i, 2, &d) == 0)
+        return 0;
+    while (i < n && is_space((unsigned char)s[i]))
+        i++;
+    if (i != n)
+        return 0;
+    if (yd <= 2)
+        y += 2000;
+
+    int leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+    if (y < 1 || m < 1 || m > 12 || d < 1 || d > days_in[m - 1] + (m == 2 && leap))
+        return 0;
+    int py = y - 1;
+    return py * 365 + py / 4 - py / 100 + py / 400 + before[m - 1] + (m > 2 && leap) + d;
+}
+
+static PyObject *
+to_day(PyObject *Py_UNUSED(self), PyObject *arg)
+{
+    Py_ssize_t n;
+    const char *s = PyUnicode_AsUTF8AndSize(arg, &n);
+    if (s == NULL)
+        return NULL;
+    return PyLong_FromLong(parse_day(s, n));
+}
+
+typedef struct {
+    Buf arena;
+    Buf column[B_COUNT]; /* Span 배열 */
+    Buf id;              /* long long 배열 */
+    Buf day;             /* int 배열 */
+    Py_ssize_t count;
+    const char *address;
+    Py_ssize_t address_len;
+} BatchBuilder;
+
+/* arena 에 붙이고 Span 을 기록한다. 깨진 UTF-8 은 scan_notices 처럼 U+FFFD 로. */
+static int
+batch_put(BatchBuilder *bb, int k, const char *prefix, Py_ssize_t prefix_len, const char *s,
+          Py_ssize_t n)
+{
+    Span span = {bb->arena.len, 0};
+    if (buf_put(&bb->arena, prefix, prefix_len) < 0)
+        return -1;
+    if (utf8_valid((const unsigned char *)s, n)) {
+        if (buf_put(&bb->arena, s, n) < 0)
+            return -1;
+    }
+    else {
+        PyObject *text = PyUnicode_DecodeUTF8(s, n, "replace");
+        if (text == NULL)
+            return -1;
+        Py_ssize_t len;
+        const char *utf8 = PyUnicode_AsUTF8AndSize(text, &len);
+        int rc = utf8 == NULL ? -1 : buf_put(&bb->arena, utf8, len);
+        Py_DECREF(text);
+        if (rc < 0)
+            return -1;
+    }
+    span.end = bb->arena.len;
+    return buf_put(&bb->column[k], (const char *)&span, sizeof(span));
+}
+
+static int
+batch_sink(Row *row, void *ctx)
+{
+    BatchBuilder *bb = ctx;
+    Buf *f = row->field;
+    Buf pattern = {0}, clean = {0};
+    const char *title;
+    Py_ssize_t title_len;
+    int rc = -1;
+
+    /* toNotices: title.replace("[writer]", "").strip() */
+    if (buf_put(&pattern, "[", 1) < 0 ||
+        buf_put(&pattern, f[F_WRITER].data, f[F_WRITER].len) < 0 ||
+        buf_put(&pattern, "]", 1) < 0)
+        goto done;
+    if (strip_pattern(f[F_TITLE].data ? f[F_TITLE].data : "", f[F_TITLE].len, pattern.data,
+                      pattern.len, &clean, &title, &title_len) < 0)
+        goto done;
+
+    long long id = parse_id(f[F_ID].data, f[F_ID].len);
+    int day = parse_day(f[F_DATE].data, f[F_DATE].len);
+    if (buf_put(&bb->id, (const char *)&id, sizeof(id)) < 0 ||
+        buf_put(&bb->day, (const char *)&day, sizeof(day)) < 0 ||
+        batch_put(bb, B_TITLE, "", 0, title, title_len) < 0 ||
+        batch_put(bb, B_DATE, "", 0, f[F_DATE].data, f[F_DATE].len) < 0 ||
+        batch_put(bb, B_WRITER, "", 0, f[F_WRITER].data, f[F_WRITER].len) < 0 ||
+        batch_put(bb, B_LINK, bb->address, bb->address_len, f[F_HREF].data, f[F_HREF].len) < 0)
+        goto done;
+    bb->count++;
+    rc = 0;
+
+done:
+    buf_free(&pattern);
+    buf_free(&clean);
+    return rc;
+}
+
+static void
+builder_free(BatchBuilder *bb)
+{
+    buf_free(&bb->arena);
+    buf_free(&bb->id);
+    buf_free(&bb->day);
+    for (int k = 0; k < B_COUNT; k++)
+        buf_free(&bb->column[k]);
+}
+
+static PyObject *
+scan_batch(PyObject *Py_UNUSED(self), PyObject *args)
+{
+    Py_buffer view;
+    BatchBuilder bb;
+    memset(&bb, 0, sizeof(bb));
+
+    if (!PyArg_ParseTuple(args, "y*s#", &view, &bb.address, &bb.address_len))
+        return NULL;
+    int rc = scan_rows(view.buf, view.len, batch_sink, &bb);
+    PyBuffer_Release(&view);
+    if (rc < 0) {
+        builder_free(&bb);
+        return NULL;
+    }
+    if (rc == 1) /* td.b-no-post */
+        bb.count = 0;
+
+    NoticeBatch *batch = PyObject_New(NoticeBatch, &NoticeBatchType);
+    if (batch == NULL) {
+        builder_free(&bb);
+        return NULL;
+    }
+    /* Buf 의 메모리를 그대로 넘겨받는다 (복사 X) */
+    batch->arena = bb.arena.data;
+    batch->arena_len = bb.arena.len;
+    batch->id = (long long *)bb.id.data;
+    batch->day = (int *)bb.day.data;
+    batch->count = bb.count;
+    for (int k = 0; k < B_COUNT; k++)
+        batch->column[k] = (Span *)bb.column[k].data;
+    return (PyObject *)batch;
+}
+
+static void
+batch_dealloc(NoticeBatch *self)
+{
+    PyMem_Free(self->arena);
+    PyMem_Free(self->id);
+    PyMem_Free(self->day);
+    for (int k = 0; k < B_COUNT; k++)
+        PyMem_Free(self->column[k]);
+    PyObject_Free(self);
+}
+
+static Py_ssize_t
+batch_len(NoticeBatch *self)
+{
+    return self->count;
+}
+
+static int
+batch_index(NoticeBatch *self, Py_ssize_t *i)
+{
+    if (*i < 0)
+        *i += self->count;
+    if (*i < 0 || *i >= self->count) {
+        PyErr_SetString(PyExc_IndexError, "notice index out of range");
+        return -1;
+    }
+    return 0;
+}
+
+static PyObject *
+batch_str(NoticeBatch *self, int k, Py_ssize_t i)
+{
+    Span span = self->column[k][i];
+    const char *a = self->arena ? self->arena : "";
+    return PyUnicode_DecodeUTF8(a + span.start, span.end - span.start, "strict");
+}
+
+static PyObject *
+batch_get(NoticeBatch *self, PyObject *arg, int k)
+{
+    Py_ssize_t i = PyLong_AsSsize_t(arg);
+    if (i == -1 && PyErr_Occurred())
+        return NULL;
+    if (batch_index(self, &i) < 0)
+        return NULL;
+    return batch_str(self, k, i);
+}
+
+static PyObject *
+batch_id(NoticeBatch *self, PyObject *arg)
+{
+    Py_ssize_t i = PyLong_AsSsize_t(arg);
+    if ((i == -1 && PyErr_Occurred()) || batch_index(self, &i) < 0)
+        return NULL;
+    return PyLong_FromLongLong(self->id[i]);
+}
+
+static PyObject *
+batch_day(NoticeBatch *self, PyObject *arg)
+{
+    Py_ssize_t i = PyLong_AsSsize_t(arg);
+    if ((i == -1 && PyErr_Occurred()) || batch_index(self, &i) < 0)
+        return NULL;
+    return PyLong_FromLong(self->day[i]);
+}
+
+static PyObject *
+batch_title(NoticeBatch *self, PyObject *i)
+{
+    return batch_get(self, i, B_TITLE);
+}
+
+static PyObject *
+batch_date(NoticeBatch *self, PyObject *i)
+{
+    return batch_get(self, i, B_DATE);
+}
+
+static PyObject *
+batch_writer(NoticeBatch *self, PyObject *i)
+{
+    return batch_get(self, i, B_WRITER);
+}
+
+static PyObject *
+batch_link(NoticeBatch *self, PyObject *i)
+{
+    return batch_get(self, i, B_LINK);
+}
+
+/* (id, title, date, link, writer): Ktemplate.buildCard 인자 순서 */
+static PyObject *
+batch_row(NoticeBatch *self, PyObject *arg)
+{
+    static const int order[4] = {B_TITLE, B_DATE, B_LINK, B_WRITER};
+    Py_ssize_t i = PyLong_AsSsize_t(arg);
+    if ((i == -1 && PyErr_Occurred()) || batch_index(self, &i) < 0)
+        return NULL;
+    PyObject *row = PyTuple_New(5);
+    if (row == NULL)
+        return NULL;
+    PyObject *id = PyLong_FromLongLong(self->id[i]);
+    if (id == NULL) {
+        Py_DECREF(row);
+        return NULL;
+    }
+    PyTuple_SET_ITEM(row, 0, id);
+    for (int k = 0; k < 4; k++) {
+        PyObject *v = batch_str(self, order[k], i);
+        if (v == NULL) {
+            Py_DECREF(row);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(row, k + 1, v);
+    }
+    return row;
+}
+
+/* span(i, column) -> (start, end): memoryview(batch)[start:end] 로 복사 없이 읽는다. */
+static PyObject *
+batch_span(NoticeBatch *self, PyObject *args)
+{
+    Py_ssize_t i;
+    const char *name;
+    if (!PyArg_ParseTuple(args, "ns", &i, &name) || batch_index(self, &i) < 0)
+        return NULL;
+    for (int k = 0; k < B_COUNT; k++) {
+        if (strcmp(name, B_NAMES[k]) == 0) {
+            Span span = self->column[k][i];
+            return Py_BuildValue("nn", span.start, span.end);
+        }
+    }
+    PyErr_Format(PyExc_KeyError, "%s", name);
+    return NULL;
+}
+
+/* 앞에서부터 day(i) == day 인 공지 수 (오늘 공지) */
+static PyObject *
+batch_leading(NoticeBatch *self, PyObject *arg)
+{
+    long day = PyLong_AsLong(arg);
+    if (day == -1 && PyErr_Occurred())
+        return NULL;
+    Py_ssize_t i = 0;
+    while (i < self->count && self->day[i] == day)
+        i++;
+    return PyLong_FromSsize_t(i);
+}
+
+static PyObject *
+batch_to_cards(NoticeBatch *self, PyObject *args, PyObject *kwargs)
+{
+    static char *kwlist[] = {"stop", "put_date", NULL};
+    Py_ssize_t stop = -1;
+    int put_date = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|np", kwlist, &stop, &put_date))
+        return NULL;
+    if (stop < 0 || stop > self->count)
+        stop = self->count;
+
+    PyObject *cards = PyList_New(stop);
+    if (cards == NULL)
+        return NULL;
+    Buf out = {0};
+    for (Py_ssize_t i = 0; i < stop; i++) {
+        Span t = self->column[B_TITLE][i], d = self->column[B_DATE][i];
+        Span l = self->column[B_LINK][i], w = self->column[B_WRITER][i];
+        const char *a = self->arena ? self->arena : "";
+        out.len = 0;
+        if (put_card(&out, a + t.start, t.end - t.start, a + d.start, d.end - d.start,
+                     a + l.start, l.end - l.start, a + w.start, w.end - w.start, put_date) < 0)
+            goto fail;
+        PyObject *card = PyBytes_FromStringAndSize(out.data, out.len);
+        if (card == NULL)
+            goto fail;
+        PyList_SET_ITEM(cards, i, card);
+    }
+    buf_free(&out);
+    return cards;
+
+fail:
+    buf_free(&out);
+    Py_DECREF(cards);
+    return NULL;
+}
+
+/* arena 는 만든 뒤 바뀌지 않으므로 read-only 로 그대로 내보낸다. */
+static int
+batch_getbuffer(NoticeBatch *self, Py_buffer *view, int flags)
+{
+    return PyBuffer_FillInfo(view, (PyObject *)self, self->arena ? self->arena : "",
+                             self->arena_len, 1, flags);
+}
+
+static PyObject *
+batch_repr(NoticeBatch *self)
+{
+    return PyUnicode_FromFormat("<NoticeBatch %zd notices, %zd bytes>", self->count,
+                                self->arena_len);
+}
+
+/*
+ * dump() / load_batch(): 열 배열과 arena 를 그대로 이어 붙인 bytes.
+ *     [count][arena_len][id * count][day * count][Span * count * B_COUNT][arena]
+ * 같은 빌드의 프로세스끼리 (fork 한 워커) 주고받는 용도라 엔디언/크기는 그대로 둔다.
+ */
+#define BATCH_HEADER (2 * (Py_ssize_t)sizeof(Py_ssize_t))
+
+static Py_ssize_t
+batch_dump_size(Py_ssize_t count, Py_ssize_t arena_len)
+{
+    Py_ssize_t row = (Py_ssize_t)(sizeof(long long) + sizeof(int) + B_COUNT * sizeof(Span));
+    if (count < 0 || arena_len < 0 || count > (PY_SSIZE_T_MAX - BATCH_HEADER) / row ||
+        arena_len > PY_SSIZE_T_MAX - BATCH_HEADER - count * row)
+        return -1;
+    return BATCH_HEADER + count * row + arena_len;
+}
+
+static PyObject *
+batch_dump(NoticeBatch *self, PyObject *Py_UNUSED(ignored))
+{
+    Py_ssize_t size = batch_dump_size(self->count, self->arena_len);
+    PyObject *out = PyBytes_FromStringAndSize(NULL, size);
+    if (out == NULL)
+        return NULL;
+    char *p = PyBytes_AS_STRING(out);
+    memcpy(p, &self->count, sizeof(Py_ssize_t));
+    memcpy(p + sizeof(Py_ssize_t), &self->arena_len, sizeof(Py_ssize_t));
+    p += BATCH_HEADER;
+    if (self->count > 0) {
+        memcpy(p, self->id, (size_t)self->count * sizeof(long long));
+        p += self->count * sizeof(long long);
+        memcpy(p, self->day, (size_t)self->count * sizeof(int));
+        p += self->count * sizeof(int);
+        for (int k = 0; k < B_COUNT; k++) {
+            memcpy(p, self->column[k], (size_t)self->count * sizeof(Span));
+            p += self->count * sizeof(Span);
+        }
+    }
+    if (self->arena_len > 0)
+        memcpy(p, self->arena, (size_t)self->arena_len);
+    return out;
+}
+
+/* 길이를 맞춰 복사한다. n == 0 이면 NULL (scan_batch 의 빈 Buf 와 같이) */
+static void *
+batch_copy(const char **p, Py_ssize_t n)
+{
+    if (n == 0)
+        return NULL;
+    void *out = PyMem_Malloc((size_t)n);
+    if (out == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    memcpy(out, *p, (size_t)n);
+    *p += n;
+    return out;
+}
+
+static PyObject *
+load_batch(PyObject *Py_UNUSED(self), PyObject *arg)
+{
+    Py_buffer view;
+    Py_ssize_t count, arena_len;
+
+    if (PyObject_GetBuffer(arg, &view, PyBUF_SIMPLE) < 0)
+        return NULL;
+    if (view.len < BATCH_HEADER)
+        goto corrupt;
+    memcpy(&count, view.buf, sizeof(Py_ssize_t));
+    memcpy(&arena_len, (const char *)view.buf + sizeof(Py_ssize_t), sizeof(Py_ssize_t));
+    if (batch_dump_size(count, arena_len) != view.len)
+        goto corrupt;
+
+    NoticeBatch *batch = PyObject_New(NoticeBatch, &NoticeBatchType);
+    if (batch == NULL) {
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+    batch->count = count;
+    batch->arena_len = arena_len;
+    batch->arena = NULL;
+    batch->id = NULL;
+    batch->day = NULL;
+    for (int k = 0; k < B_COUNT; k++)
+        batch->column[k] = NULL;
+
+    const char *p = (const char *)view.buf + BATCH_HEADER;
+    if (count > 0) {
+        if ((batch->id = batch_copy(&p, count * (Py_ssize_t)sizeof(long long))) == NULL ||
+            (batch->day = batch_copy(&p, count * (Py_ssize_t)sizeof(int))) == NULL)
+            goto fail;
+        for (int k = 0; k < B_COUNT; k++)
+            if ((batch->column[k] = batch_copy(&p, count * (Py_ssize_t)sizeof(Span))) == NULL)
+                goto fail;
+    }
+    if (arena_len > 0 && (batch->arena = batch_copy(&p, arena_len)) == NULL)
+        goto fail;
+    PyBuffer_Release(&view);
+
+    /* str() 과 to_cards() 가 arena 를 믿고 읽으므로 span 과 UTF-8 을 확인한다 */
+    for (int k = 0; k < B_COUNT; k++) {
+        for (Py_ssize_t i = 0; i < count; i++) {
+            Span span = batch->column[k][i];
+            const char *a = batch->arena ? batch->arena : "";
+            if (span.start < 0 || span.start > span.end || span.end > arena_len ||
+                !utf8_valid((const unsigned char *)a + span.start,
+                            span.end - span.start)) {
+                Py_DECREF(batch);
+                PyErr_SetString(PyExc_ValueError, "corrupt NoticeBatch dump");
+                return NULL;
+            }
+        }
+    }
+    return (PyObject *)batch;
+
+fail:
+    PyBuffer_Release(&view);
+    Py_DECREF(batch);
+    return NULL;
+
+corrupt:
+    PyBuffer_Release(&view);
+    PyErr_SetString(PyExc_ValueError, "corrupt NoticeBatch dump");
+    return NULL;
+}
+
+static PyMethodDef batch_methods[] = {
+    {"id", (PyCFunction)batch_id, METH_O, "id(i) -> int (고정 공지는 0)"},
+    {"day", (PyCFunction)batch_day, METH_O, "day(i) -> date.toordinal()"},
+    {"title", (PyCFunction)batch_title, METH_O, "title(i) -> str"},
+    {"date", (PyCFunction)batch_date, METH_O, "date(i) -> str"},
+    {"writer", (PyCFunction)batch_writer, METH_O, "writer(i) -> str"},
+    {"link", (PyCFunction)batch_link, METH_O, "link(i) -> str"},
+    {"row", (PyCFunction)batch_row, METH_O, "row(i) -> (id, title, date, link, writer)"},
+    {"span", (PyCFunction)batch_span, METH_VARARGS, "span(i, column) -> (start, end)"},
+    {"leading", (PyCFunction)batch_leading, METH_O, "leading(day) -> int"},
+    {"to_cards", (PyCFunction)(void (*)(void))batch_to_cards, METH_VARARGS | METH_KEYWORDS,
+     "to_cards(stop=-1, put_date=False) -> [list card bytes, ...]"},
+    {"dump", (PyCFunction)batch_dump, METH_NOARGS, "dump() -> bytes (load_batch 로 되돌린다)"},
+    {NULL, NULL, 0, NULL},
+};
+
+static PySequenceMethods batch_as_sequence = {
+    .sq_length = (lenfunc)batch_len,
+};
+
+static PyBufferProcs batch_as_buffer = {
+    .bf_getbuffer = (getbufferproc)batch_getbuffer,
+};
+
+static PyTypeObject NoticeBatchType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "ajou_native.NoticeBatch",
+    .tp_basicsize = sizeof(NoticeBatch),
+    .tp_dealloc = (destructor)batch_dealloc,
+    .tp_repr = (reprfunc)batch_repr,
+    .tp_as_sequence = &batch_as_sequence,
+    .tp_as_buffer = &batch_as_buffer,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "scan_batch() 가 만드는 공지 목록 (struct-of-arrays)",
+    .tp_methods = batch_methods,
+};
+
+/* ---------------------------------------------------------- skill skimmer */
+
+typedef struct {
+    const char *p;
+    const char *end;
+    const char *error; /* 구조 오류 메시지 (GIL 없이 쓰이므로 PyErr 대신) */
+} Json;
+
+#define SKIM_FALLBACK 1 /* 처리하지 않는 값, json.loads 로 */
+
+static int
+json_error(Json *j, const char *what)
+{
+    j->error = what;
+    return -1;
+}
+
+static char
+json_peek(Json *j)
+{
+    return j->p < j->end ? *j->p : '\0';
+}
+
+static void
+json_ws(Json *j)
+{
+    while (j->p < j->end && (*j->p == ' ' || *j->p == '\t' || *j->p == '\n' || *j->p == '\r'))
+        j->p++;
+}
+
+static int
+json_expect(Json *j, char c)
+{
+    json_ws(j);
+    if (j->p >= j->end || *j->p != c)
+        return json_error(j, "unexpected character");
+    j->p++;
+    return 0;
+}
+
+/* '"' 위치에서 시작해 닫는 '"' 다음으로 간다. [*s, *s + *n) 은 escape 된 그대로의 내용 */
+static int
+json_string_span(Json *j, const char **s, Py_ssize_t *n, int *escaped)
+{
+    if (j->p >= j->end || *j->p != '"')
+        return json_error(j, "expected string");
+    const char *start = ++j->p;
+    *escaped = 0;
+    while (j->p < j->end) {
+        unsigned char c = (unsigned char)*j->p;
+        if (c == '"') {
+            *s = start;
+            *n = j->p - start;
+            j->p++;
+            return 0;
+        }
+        if (c == '\\') {
+            *escaped = 1;
+            j->p += 2;
+            continue;
+        }
+        if (c < 0x20)
+            return json_error(j, "control character in string");
+        j->p++;
+    }
+    return json_error(j, "unterminated string");
+}
+
+static int
+hex4(const char *s, unsigned long *out)
+{
+    unsigned long v = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = s[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9')
+            v |= (unsigned long)(c - '0');
+        else if (c >= 'a' && c <= 'f')
+            v |= (unsigned long)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F')
+            v |= (unsigned long)(c - 'A' + 10);
+        else
+            return -1;
+    }
+    *out = v;
+    return 0;
+}
+
+/* 문자열 내용(escape 된 그대로)을 str 로. json.loads 처럼 짝 없는 surrogate 도 남긴다. */
+static PyObject *
+json_unescape(const char *s, Py_ssize_t n, int escaped)
+{
+    if (!escaped)
+        return PyUnicode_DecodeUTF8(s, n, "surrogatepass");
+
+    Buf out = {0};
+    Py_ssize_t run = 0;
+    for (Py_ssize_t i = 0; i < n; i++) {
+        if (s[i] != '\\')
+            continue;
+        if (buf_put(&out, s + run, i - run) < 0)
+            goto fail;
+        char c = s[++i];
+        const char *rep = NULL;
+        switch (c) {
+        case '"': rep = "\""; break;
+        case '\\': rep = "\\"; break;
+        case '/': rep = "/"; break;
+        case 'b': rep = "\b"; break;
+        case 'f': rep = "\f"; break;
+        case 'n': rep = "\n"; break;
+        case 'r': rep = "\r"; break;
+        case 't': rep = "\t"; break;
+        case 'u': {
+            unsigned long cp, lo;
+            int rc;
+            if (i + 4 >= n || hex4(s + i + 1, &cp) < 0) {
+                PyErr_SetString(PyExc_ValueError, "invalid \\u escape");
+                goto fail;
+            }
+            i += 4;
+            if (cp >= 0xD800 && cp <= 0xDBFF && i + 6 < n && s[i + 1] == '\\' &&
+                s[i + 2] == 'u' && hex4(s + i + 3, &lo) == 0 && lo >= 0xDC00 && lo <= 0xDFFF) {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                i += 6;
+            }
+            if (cp == 0) {
+                rc = buf_put(&out, "", 1);
+            }
+            else if (cp >= 0xD800 && cp <= 0xDFFF) {
+                /* put_utf8 은 U+FFFD 로 바꾸므로 직접 (surrogatepass 로 되돌아온다) */
+                char tmp[3] = {(char)(0xE0 | (cp >> 12)), (char)(0x80 | ((cp >> 6) & 0x3F)),
+                               (char)(0x80 | (cp & 0x3F))};
+                rc = buf_put(&out, tmp, 3);
+            }
+            else {
+                rc = put_utf8(&out, cp);
+            }
+            if (rc < 0)
+                goto fail;
+            break;
+        }
+        default:
+            PyErr_SetString(PyExc_ValueError, "invalid escape");
+            goto fail;
+        }
+        if (rep != NULL && buf_put(&out, rep, 1) < 0)
+            goto fail;
+        run = i + 1;
+    }
+    if (buf_put(&out, s + run, n - run) < 0)
+        goto fail;
+    PyObject *res = PyUnicode_DecodeUTF8(out.data ? out.data : "", out.len, "surrogatepass");
+    buf_free(&out);
+    return res;
+
+fail:
+    buf_free(&out);
+    return NULL;
+}
+
+static PyObject *
+json_read_string(Json *j)
+{
+    const char *s;
+    Py_ssize_t n;
+    int escaped;
+    if (json_string_span(j, &s, &n, &escaped) < 0)
+        return NULL;
+    return json_unescape(s, n, escaped);
+}
+
+/* 값 하나를 해석하지 않고 건너뛴다. (괄호 짝과 문자열만 본다) */
+static int
+json_skip(Json *j)
+{
+    const char *s;
+    Py_ssize_t n;
+    int escaped;
+
+    json_ws(j);
+    if (j->p >= j->end)
+        return json_error(j, "expected value");
+    char c = *j->p;
+    if (c == '"')
+        return json_string_span(j, &s, &n, &escaped);
+    if (c == '{' || c == '[') {
+        Py_ssize_t depth = 0;
+        while (j->p < j->end) {
+            c = *j->p;
+            if (c == '"') {
+                if (json_string_span(j, &s, &n, &escaped) < 0)
+                    return -1;
+                continue;
+            }
+            if (c == '{' || c == '[')
+                depth++;
+            else if (c == '}' || c == ']') {
+                if (--depth == 0) {
+                    j->p++;
+                    return 0;
+                }
+            }
+            j->p++;
+        }
+        return json_error(j, "unterminated container");
+    }
+    const char *start = j->p;
+    while (j->p < j->end && !strchr(",}] \t\r\n", *j->p))
+        j->p++;
+    return j->p > start ? 0 : json_error(j, "expected value");
+}
+
+/*
+ * object 의 다음 key. 1 = key 를 읽고 ':' 뒤에 섰다, 0 = '}' 로 끝났다, -1 = 오류
+ * 구조용 key 는 escape 된 그대로 비교한다. (카카오 key 에는 escape 가 없다)
+ */
+static int
+json_next_key(Json *j, int *first, const char **key, Py_ssize_t *key_len, int *escaped)
+{
+    json_ws(j);
+    if (j->p < j->end && *j->p == '}') {
+        j->p++;
+        return 0;
+    }
+    if (!*first && json_expect(j, ',') < 0)
+        return -1;
+    *first = 0;
+    json_ws(j);
+    if (json_string_span(j, key, key_len, escaped) < 0 || json_expect(j, ':') < 0)
+        return -1;
+    json_ws(j);
+    return 1;
+}
+
+static int
+key_is(const char *key, Py_ssize_t key_len, const char *name)
+{
+    return (size_t)key_len == strlen(name) && memcmp(key, name, (size_t)key_len) == 0;
+}
+
+/* *slot 에 문자열 값을 넣는다. 문자열이 아니면 건너뛰고 그대로 둔다. */
+static int
+json_take_string(Json *j, PyObject **slot)
+{
+    if (json_peek(j) == '"') {
+        PyObject *value = json_read_string(j);
+        if (value == NULL)
+            return -1;
+        Py_XSETREF(*slot, value);
+        return 0;
+    }
+    return json_skip(j);
+}
+
+typedef struct {
+    PyObject *user_id;
+    PyObject *utterance;
+    PyObject *params;
+} Skill;
+
+/* {"user": {"id": ...}, "utterance": ...} */
+static int
+skim_user_request(Json *j, Skill *skill)
+{
+    const char *key;
+    Py_ssize_t key_len;
+    int first = 1, escaped, rc;
+
+    if (json_expect(j, '{') < 0)
+        return -1;
+    while ((rc = json_next_key(j, &first, &key, &key_len, &escaped)) == 1) {
+        if (key_is(key, key_len, "utterance")) {
+            if (json_take_string(j, &skill->utterance) < 0)
+                return -1;
+        }
+        else if (key_is(key, key_len, "user") && json_peek(j) == '{') {
+            const char *ukey;
+            Py_ssize_t ukey_len;
+            int ufirst = 1, urc;
+            j->p++;
+            while ((urc = json_next_key(j, &ufirst, &ukey, &ukey_len, &escaped)) == 1) {
+                if ((key_is(ukey, ukey_len, "id") ? json_take_string(j, &skill->user_id)
+                                                   : json_skip(j)) < 0)
+                    return -1;
+            }
+            if (urc < 0)
+                return -1;
+        }
+        else if (json_skip(j) < 0) {
+            return -1;
+        }
+    }
+    return rc;
+}
+
+/* {"params": {key: "value", ...}, ...} */
+static int
+skim_action(Json *j, Skill *skill)
+{
+    const char *key;
+    Py_ssize_t key_len;
+    int first = 1, escaped, rc;
+
+    if (json_expect(j, '{') < 0)
+        return -1;
+    while ((rc = json_next_key(j, &first, &key, &key_len, &escaped)) == 1) {
+        if (!key_is(key, key_len, "params") || json_peek(j) != '{') {
+            if (json_skip(j) < 0)
+                return -1;
+            continue;
+        }
+        const char *pkey;
+        Py_ssize_t pkey_len;
+        int pfirst = 1, prc;
+        j->p++;
+        while ((prc = json_next_key(j, &pfirst, &pkey, &pkey_len, &escaped)) == 1) {
+            if (json_peek(j) != '"')
+                return SKIM_FALLBACK;
+            PyObject *name = json_unescape(pkey, pkey_len, escaped);
+            PyObject *value = name ? json_read_string(j) : NULL;
+            int err = value == NULL || PyDict_SetItem(skill->params, name, value) < 0;
+            Py_XDECREF(name);
+            Py_XDECREF(value);
+            if (err)
+                return -1;
+        }
+        if (prc < 0)
+            return -1;
+    }
+    return rc;
+}
+
+static PyObject *
+skim_skill(PyObject *Py_UNUSED(self), PyObject *arg)
+{
+    Py_buffer view;
+    Skill skill = {NULL, NULL, NULL};
+    PyObject *res = NULL;
+    const char *key;
+    Py_ssize_t key_len;
+    int first = 1, escaped, rc;
+
+    if (PyObject_GetBuffer(arg, &view, PyBUF_SIMPLE) < 0)
+        return NULL;
+    Json j = {(const char *)view.buf, (const char *)view.buf + view.len, NULL};
+    if ((skill.params = PyDict_New()) == NULL)
+        goto done;
+
+    if (j.end - j.p >= 3 && memcmp(j.p, "\xEF\xBB\xBF", 3) == 0)
+        j.p += 3; /* BOM */
+    if (json_expect(&j, '{') < 0)
+        goto done;
+    while ((rc = json_next_key(&j, &first, &key, &key_len, &escaped)) == 1) {
+        if (key_is(key, key_len, "userRequest") && json_peek(&j) == '{')
+            rc = skim_user_request(&j, &skill);
+        else if (key_is(key, key_len, "action") && json_peek(&j) == '{')
+            rc = skim_action(&j, &skill);
+        else
+            rc = json_skip(&j);
+        if (rc != 0)
+            break;
+    }
+    if (rc == SKIM_FALLBACK) {
+        res = Py_NewRef(Py_None);
+        goto done;
+    }
+    if (rc < 0)
+        goto done;
+    json_ws(&j);
+    if (j.p != j.end) {
+        json_error(&j, "extra data");
+        goto done;
+    }
+
+    res = PyTuple_Pack(3, skill.user_id ? skill.user_id : Py_None, skill.params,
+                       skill.utterance ? skill.utterance : Py_None);
+
+done:
+    if (res == NULL && j.error != NULL && !PyErr_Occurred())
+        PyErr_Format(PyExc_ValueError, "%s (%zd bytes left)", j.error,
+                     (Py_ssize_t)(j.end - j.p));
+    Py_XDECREF(skill.user_id);
+    Py_XDECREF(skill.utterance);
+    Py_XDECREF(skill.params);
+    PyBuffer_Release(&view);
+    return res;
+}
+
+/* -------------------------------------------------------- http front-end */
+
+#ifdef __linux__
+
+/*
+ * 루프 스레드는 GIL 없이 돈다. 그래서 이 절의 메모리는 PyMem 이 아니라 malloc 이고,
+ * Python 쪽 (publish / next / reply / drain_users) 과는 lock 으로만 주고받는다.
+ */
+
+#define HEAD_LIMIT 8192    /* request line + header */
+#define READ_CHUNK 65536   /* EPOLLIN 한 번에 읽는 양 */
+#define USER_LIMIT 65536   /* drain_users() 전까지 쌓아두는 유저 수 */
+#define SEEN_SLOTS 4096    /* 최근 넘긴 user.id (같은 유저를 매번 큐에 넣지 않는다) */
+#define ROUTE_KEY_LIMIT 512
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} Bytes;
+
+static int
+bytes_reserve(Bytes *b, size_t extra)
+{
+    size_t need = b->len + extra;
+    if (need <= b->cap)
+        return 0;
+    size_t cap = b->cap ? b->cap : 1024;
+    while (cap < need)
+        cap *= 2;
+    char *p = realloc(b->data, cap);
+    if (p == NULL)
+        return -1;
+    b->data = p;
+    b->cap = cap;
+    return 0;
+}
+
+static int
+bytes_put(Bytes *b, const char *s, size_t n)
+{
+    if (n == 0)
+        return 0;
+    if (bytes_reserve(b, n) < 0)
+        return -1;
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+    return 0;
+}
+
+/* 앞 n byte 를 버린다. (처리한 요청) */
+static void
+bytes_consume(Bytes *b, size_t n)
+{
+    memmove(b->data, b->data + n, b->len - n);
+    b->len -= n;
+}
+
+/* publish() 한 응답 하나: key -> 완성된 HTTP 응답 변형들 */
+typedef struct {
+    char *key;
+    size_t key_len;
+    int track; /* 이 경로로 온 user.id 를 drain_users() 로 넘긴다 */
+    Py_ssize_t count;
+    Bytes *responses;
+} Route;
+
+typedef struct {
+    Route *routes;
+    Py_ssize_t count;
+} Table;
+
+static void
+table_free(Table *t)
+{
+    if (t == NULL)
+        return;
+    for (Py_ssize_t i = 0; i < t->count; i++) {
+        for (Py_ssize_t k = 0; k < t->routes[i].count; k++)
+            free(t->routes[i].responses[k].data);
+        free(t->routes[i].responses);
+        free(t->routes[i].key);
+    }
+    free(t->routes);
+    free(t);
+}
+
+/* Python 으로 넘기는 요청 (head + body 복사본) */
+typedef struct Pending {
+    struct Pending *next;
+    uint64_t token;
+    char *data;
+    size_t head_len;
+    size_t body_len;
+} Pending;
+
+typedef struct Reply {
+    struct Reply *next;
+    uint64_t token;
+    char *data;
+    size_t len;
+    int close;
+} Reply;
+
+typedef struct {
+    int fd;
+    uint32_t serial;
+    uint32_t events; /* 지금 epoll 에 걸어둔 것 */
+    Bytes in;
+    Bytes out;
+    size_t out_off;
+    int waiting;   /* Python 응답을 기다리는 중 (다음 요청은 읽지 않는다) */
+    int keep;      /* 지금 요청이 keep-alive 인가 */
+    int http10;    /* 지금 요청이 HTTP/1.0 (keep-alive 면 응답에 알려야 한다) */
+    int closing;   /* out 을 다 보내면 닫는다 */
+    int continued; /* 100 Continue 를 이미 보냈다 */
+} Conn;
+
+typedef struct {
+    PyObject_HEAD
+    int listen_fd;
+    int epoll_fd;
+    int wake_fd;
+    size_t max_body;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    int running;
+    int stopping;
+    /* lock 으로 보호 */
+    Table *table;
+    Pending *pending_head;
+    Pending *pending_tail;
+    size_t pending_count;
+    Reply *replies;
+    char **users;
+    size_t user_count;
+    char *seen[SEEN_SLOTS];
+    /* 루프 스레드 전용 */
+    Conn **conns;
+    int conn_cap;
+    uint32_t serial;
+    uint64_t rng;
+    /* 통계 (루프 스레드만 쓴다) */
+    unsigned long long connections;
+    unsigned long long requests;
+    unsigned long long native;
+    unsigned long long fallback;
+    unsigned long long rejected;
+    unsigned long long dropped_users;
+} Server;
+
+/* ---- 스킬 payload 에서 라우팅에 필요한 span 만 (GIL X) */
+
+typedef struct {
+    const char *user;
+    Py_ssize_t user_len;
+    const char *name;
+    Py_ssize_t name_len;
+    const char *value;
+    Py_ssize_t value_len;
+    int params;
+} SkillSpan;
+
+/* escape 없는 문자열만 받는다. (그 외는 -1, Python 이 처리) */
+static int
+span_plain_string(Json *j, const char **s, Py_ssize_t *n)
+{
+    int escaped;
+    if (json_peek(j) != '"' || json_string_span(j, s, n, &escaped) < 0)
+        return -1;
+    return escaped ? -1 : 0;
+}
+
+static int
+span_user_request(Json *j, SkillSpan *sp)
+{
+    const char *key;
+    Py_ssize_t key_len;
+    int first = 1, escaped, rc;
+
+    if (json_expect(j, '{') < 0)
+        return -1;
+    while ((rc = json_next_key(j, &first, &key, &key_len, &escaped)) == 1) {
+        if (!key_is(key, key_len, "user") || json_peek(j) != '{') {
+            if (json_skip(j) < 0)
+                return -1;
+            continue;
+        }
+        const char *ukey;
+        Py_ssize_t ukey_len;
+        int ufirst = 1, urc;
+        j->p++;
+        while ((urc = json_next_key(j, &ufirst, &ukey, &ukey_len, &escaped)) == 1) {
+            if (key_is(ukey, ukey_len, "id")) {
+                if (span_plain_string(j, &sp->user, &sp->user_len) < 0)
+                    return -1;
+            }
+            else if (json_skip(j) < 0) {
+                return -1;
+            }
+        }
+        if (urc < 0)
+            return -1;
+    }
+    return rc;
+}
+
+static int
+span_action(Json *j, SkillSpan *sp)
+{
+    const char *key;
+    Py_ssize_t key_len;
+    int first = 1, escaped, rc;
+
+    if (json_expect(j, '{') < 0)
+        return -1;
+    while ((rc = json_next_key(j, &first, &key, &key_len, &escaped)) == 1) {
+        if (!key_is(key, key_len, "params") || json_peek(j) != '{') {
+            if (json_skip(j) < 0)
+                return -1;
+            continue;
+        }
+        int pfirst = 1, prc;
+        j->p++;
+        while ((prc = json_next_key(j, &pfirst, &sp->name, &sp->name_len, &escaped)) == 1) {
+            if (escaped || ++sp->params > 1 ||
+                span_plain_string(j, &sp->value, &sp->value_len) < 0)
+                return -1; /* params 여러 개 / 문자열 아님 */
+        }
+        if (prc < 0)
+            return -1;
+    }
+    return rc;
+}
+
+/* 0 = sp 를 채웠다, -1 = Python 으로 넘긴다 (깨진 JSON 도) */
+static int
+skim_route(const char *body, size_t n, SkillSpan *sp)
+{
+    Json j = {body, body + n, NULL};
+    const char *key;
+    Py_ssize_t key_len;
+    int first = 1, escaped, rc;
+
+    memset(sp, 0, sizeof(*sp));
+    if (!utf8_valid((const unsigned char *)body, (Py_ssize_t)n))
+        return -1;
+    if (n >= 3 && memcmp(body, "\xEF\xBB\xBF", 3) == 0)
+        j.p += 3;
+    if (json_expect(&j, '{') < 0)
+        return -1;
+    while ((rc = json_next_key(&j, &first, &key, &key_len, &escaped)) == 1) {
+        if (key_is(key, key_len, "userRequest") && json_peek(&j) == '{')
+            rc = span_user_request(&j, sp);
+        else if (key_is(key, key_len, "action") && json_peek(&j) == '{')
+            rc = span_action(&j, sp);
+        else
+            rc = json_skip(&j);
+        if (rc != 0)
+            return -1;
+    }
+    if (rc < 0)
+        return -1;
+    json_ws(&j);
+    return j.p == j.end ? 0 : -1;
+}
+
+/* ---- 연결 */
+
+static int
+conn_watch(Server *s, Conn *c)
+{
+    uint32_t events = (c->waiting ? 0 : EPOLLIN) | (c->out_off < c->out.len ? EPOLLOUT : 0);
+    if (events == c->events)
+        return 0;
+    struct epoll_event ev = {.events = events, .data.fd = c->fd};
+    if (epoll_ctl(s->epoll_fd, EPOLL_CTL_MOD, c->fd, &ev) < 0)
+        return -1;
+    c->events = events;
+    return 0;
+}
+
+static void
+conn_close(Server *s, Conn *c)
+{
+    epoll_ctl(s->epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    s->conns[c->fd] = NULL;
+    free(c->in.data);
+    free(c->out.data);
+    free(c);
+}
+
+static Conn *
+conn_find(Server *s, uint64_t token)
+{
+    int fd = (int)(token & 0xFFFFFFFFu);
+    if (fd < 0 || fd >= s->conn_cap || s->conns[fd] == NULL)
+        return NULL;
+    Conn *c = s->conns[fd];
+    return c->serial == (uint32_t)(token >> 32) ? c : NULL;
+}
+
+/* 0 = 계속, -1 = 닫는다 */
+static int
+conn_flush(Server *s, Conn *c)
+{
+    while (c->out_off < c->out.len) {
+        ssize_t w =
+            send(c->fd, c->out.data + c->out_off, c->out.len - c->out_off, MSG_NOSIGNAL);
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            return -1;
+        }
+        c->out_off += (size_t)w;
+    }
+    if (c->out_off == c->out.len) {
+        c->out.len = c->out_off = 0;
+        if (c->closing)
+            return -1;
+    }
+    return conn_watch(s, c);
+}
+
+/* 완성된 응답을 out 에 붙인다. HTTP/1.0 keep-alive 면 상태 줄 뒤에 그 헤더를 넣는다. */
+static int
+conn_respond(Conn *c, const char *data, size_t len)
+{
+    static const char keep_alive[] = "connection: keep-alive\r\n";
+    const char *eol;
+    if (!c->http10 || !c->keep || c->closing || (eol = memmem(data, len, "\r\n", 2)) == NULL)
+        return bytes_put(&c->out, data, len);
+    size_t head = (size_t)(eol - data) + 2;
+    if (bytes_put(&c->out, data, head) < 0 ||
+        bytes_put(&c->out, keep_alive, sizeof(keep_alive) - 1) < 0)
+        return -1;
+    return bytes_put(&c->out, data + head, len - head);
+}
+
+static int
+conn_error(Server *s, Conn *c, const char *status)
+{
+    char head[128];
+    int n = snprintf(head, sizeof(head),
+                     "HTTP/1.1 %s\r\ncontent-length: 0\r\nconnection: close\r\n\r\n", status);
+    s->rejected++;
+    c->in.len = 0;
+    c->closing = 1;
+    return bytes_put(&c->out, head, (size_t)n);
+}
+
+static uint64_t
+server_random(Server *s)
+{
+    uint64_t x = s->rng; /* xorshift64 */
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return s->rng = x;
+}
+
+/* user.id 를 drain 큐에 넣는다. 최근에 넣은 id 면 (direct-mapped) 건너뛴다. (lock 안에서) */
+static void
+server_track(Server *s, const char *user, size_t n)
+{
+    uint64_t h = 0xcbf29ce484222325ull; /* FNV-1a */
+    for (size_t i = 0; i < n; i++)
+        h = (h ^ (unsigned char)user[i]) * 0x100000001b3ull;
+    char **slot = &s->seen[h % SEEN_SLOTS];
+    if (*slot != NULL && strlen(*slot) == n && memcmp(*slot, user, n) == 0)
+        return;
+
+    char *copy = malloc(n + 1), *queued = malloc(n + 1);
+    if (copy == NULL || queued == NULL || s->user_count >= USER_LIMIT) {
+        free(copy);
+        free(queued);
+        s->dropped_users++;
+        return;
+    }
+    memcpy(copy, user, n);
+    copy[n] = '\0';
+    memcpy(queued, copy, n + 1);
+    free(*slot);
+    *slot = copy;
+    s->users[s->user_count++] = queued;
+}
+
+/* 발행된 응답이 있으면 out 에 붙인다. 1 = 보냈다, 0 = Python 으로, -1 = 메모리 */
+static int
+serve_native(Server *s, Conn *c, const char *target, size_t target_len, const char *body,
+             size_t body_len)
+{
+    SkillSpan sp;
+    char key[ROUTE_KEY_LIMIT];
+    size_t key_len = target_len;
+    int rc = 0;
+
+    if (memchr(target, '?', target_len) != NULL || skim_route(body, body_len, &sp) < 0)
+        return 0;
+    if (key_len >= sizeof(key))
+        return 0;
+    memcpy(key, target, target_len);
+    if (sp.params == 1) { /* "/message?when=today" */
+        size_t extra = 2 + (size_t)sp.name_len + (size_t)sp.value_len;
+        if (key_len + extra > sizeof(key))
+            return 0;
+        key[key_len++] = '?';
+        memcpy(key + key_len, sp.name, (size_t)sp.name_len);
+        key_len += (size_t)sp.name_len;
+        key[key_len++] = '=';
+        memcpy(key + key_len, sp.value, (size_t)sp.value_len);
+        key_len += (size_t)sp.value_len;
+    }
+
+    pthread_mutex_lock(&s->lock);
+    Table *t = s->table;
+    for (Py_ssize_t i = 0; t != NULL && i < t->count; i++) {
+        Route *r = &t->routes[i];
+        if (r->key_len != key_len || memcmp(r->key, key, key_len) != 0)
+            continue;
+        Bytes *resp = &r->responses[server_random(s) % (uint64_t)r->count];
+        if (conn_respond(c, resp->data, resp->len) < 0) {
+            rc = -1;
+            break;
+        }
+        if (r->track && sp.user != NULL)
+            server_track(s, sp.user, (size_t)sp.user_len);
+        rc = 1;
+        break;
+    }
+    pthread_mutex_unlock(&s->lock);
+    return rc;
+}
+
+static int
+defer_python(Server *s, Conn *c, size_t head_len, size_t body_len)
+{
+    Pending *p = malloc(sizeof(Pending));
+    if (p == NULL || (p->data = malloc(head_len + body_len + 1)) == NULL) {
+        free(p);
+        return -1;
+    }
+    memcpy(p->data, c->in.data, head_len + body_len);
+    p->next = NULL;
+    p->token = ((uint64_t)c->serial << 32) | (uint32_t)c->fd;
+    p->head_len = head_len;
+    p->body_len = body_len;
+
+    pthread_mutex_lock(&s->lock);
+    if (s->pending_tail != NULL)
+        s->pending_tail->next = p;
+    else
+        s->pending_head = p;
+    s->pending_tail = p;
+    s->pending_count++;
+    pthread_cond_signal(&s->ready);
+    pthread_mutex_unlock(&s->lock);
+    c->waiting = 1;
+    return 0;
+}
+
+static int
+header_is(const char *s, size_t n, const char *name)
+{
+    return ieq(s, (Py_ssize_t)n, name);
+}
+
+static int
+has_token(const char *s, size_t n, const char *token)
+{
+    size_t len = strlen(token);
+    for (size_t i = 0; i + len <= n; i++)
+        if (ieq(s + i, (Py_ssize_t)len, token))
+            return 1;
+    return 0;
+}
+
+/* in 의 맨 앞 요청 하나. 1 = 처리했다, 0 = 더 읽어야 한다, -1 = 닫는다 */
+static int
+conn_request(Server *s, Conn *c)
+{
+    const char *in = c->in.data;
+    const char *end = in ? memmem(in, c->in.len, "\r\n\r\n", 4) : NULL;
+    if (end == NULL)
+        return c->in.len > HEAD_LIMIT ? conn_error(s, c, "431 Request Header Fields Too Large")
+                                      : 0;
+    size_t head_len = (size_t)(end - in) + 4;
+    if (head_len > HEAD_LIMIT)
+        return conn_error(s, c, "431 Request Header Fields Too Large");
+
+    /* METHOD SP target SP HTTP/1.x */
+    const char *line_end = memmem(in, head_len, "\r\n", 2);
+    const char *sp1 = memchr(in, ' ', (size_t)(line_end - in));
+    const char *sp2 = sp1 ? memchr(sp1 + 1, ' ', (size_t)(line_end - sp1 - 1)) : NULL;
+    if (sp1 == NULL || sp2 == NULL || line_end - sp2 - 1 != 8 || memcmp(sp2 + 1, "HTTP/1.", 7))
+        return conn_error(s, c, "400 Bad Request");
+    for (const char *m = in; m < sp1; m++)
+        if (*m < 'A' || *m > 'Z')
+            return conn_error(s, c, "400 Bad Request");
+    int http10 = sp2[8] == '0';
+    int post = sp1 - in == 4 && memcmp(in, "POST", 4) == 0;
+
+    size_t body_len = 0;
+    int keep = !http10, expect = 0, origin = 0;
+    const char *line = line_end + 2;
+    while (line < end) {
+        const char *eol = memmem(line, (size_t)(end + 2 - line), "\r\n", 2);
+        const char *colon = memchr(line, ':', (size_t)(eol - line));
+        if (colon == NULL)
+            return conn_error(s, c, "400 Bad Request");
+        const char *v = colon + 1;
+        while (v < eol && (*v == ' ' || *v == '\t'))
+            v++;
+        size_t name_len = (size_t)(colon - line), v_len = (size_t)(eol - v);
+        if (header_is(line, name_len, "content-length")) {
+            body_len = 0;
+            if (v_len == 0 || v_len > 12)
+                return conn_error(s, c, "400 Bad Request");
+            for (size_t i = 0; i < v_len; i++) {
+                if (v[i] < '0' || v[i] > '9')
+                    return conn_error(s, c, "400 Bad Request");
+                body_len = body_len * 10 + (size_t)(v[i] - '0');
+            }
+        }
+        else if (header_is(line, name_len, "transfer-encoding")) {
+            return conn_error(s, c, "411 Length Required"); /* chunked 는 uvicorn 으로 */
+        }
+        else if (header_is(line, name_len, "connection")) {
+            if (has_token(v, v_len, "close"))
+                keep = 0;
+            else if (has_token(v, v_len, "keep-alive"))
+                keep = 1;
+        }
+        else if (header_is(line, name_len, "expect")) {
+            expect = has_token(v, v_len, "100-continue");
+        }
+        else if (header_is(line, name_len, "origin")) {
+            origin = 1; /* CORS 헤더는 middleware 가 붙인다 */
+        }
+        line = eol + 2;
+    }
+    if (body_len > s->max_body)
+        return conn_error(s, c, "413 Payload Too Large");
+    if (c->in.len < head_len + body_len) {
+        if (expect && !c->continued) {
+            c->continued = 1;
+            return bytes_put(&c->out, "HTTP/1.1 100 Continue\r\n\r\n", 25) < 0 ? -1 : 0;
+        }
+        return 0;
+    }
+
+    s->requests++;
+    c->continued = 0;
+    c->keep = keep;
+    c->http10 = http10;
+    int rc = 0;
+    if (post && !origin)
+        rc = serve_native(s, c, sp1 + 1, (size_t)(sp2 - sp1 - 1), in + head_len, body_len);
+    if (rc < 0)
+        return -1;
+    if (rc == 1) {
+        s->native++;
+        c->closing = !keep;
+    }
+    else {
+        if (defer_python(s, c, head_len, body_len) < 0)
+            return -1;
+        s->fallback++;
+    }
+    bytes_consume(&c->in, head_len + body_len);
+    return 1;
+}
+
+/* 쌓인 요청을 Python 응답을 기다려야 할 때까지 처리하고 보낸다. */
+static int
+conn_process(Server *s, Conn *c)
+{
+    int rc = 1;
+    while (!c->waiting && !c->closing && (rc = conn_request(s, c)) == 1)
+        ;
+    if (rc < 0)
+        return -1;
+    return conn_flush(s, c);
+}
+
+static void
+server_accept(Server *s)
+{
+    for (;;) {
+        int fd = accept4(s->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return; /* EAGAIN, EMFILE ... 다음 epoll 에서 다시 */
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (fd >= s->conn_cap) {
+            int cap = s->conn_cap ? s->conn_cap : 1024;
+            while (cap <= fd)
+                cap *= 2;
+            Conn **conns = realloc(s->conns, sizeof(Conn *) * (size_t)cap);
+            if (conns == NULL) {
+                close(fd);
+                continue;
+            }
+            memset(conns + s->conn_cap, 0, sizeof(Conn *) * (size_t)(cap - s->conn_cap));
+            s->conns = conns;
+            s->conn_cap = cap;
+        }
+        Conn *c = calloc(1, sizeof(Conn));
+        struct epoll_event ev = {.events = EPOLLIN, .data.fd = fd};
+        if (c == NULL || epoll_ctl(s->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            free(c);
+            close(fd);
+            continue;
+        }
+        c->fd = fd;
+        c->serial = ++s->serial;
+        c->events = EPOLLIN;
+        s->conns[fd] = c;
+        s->connections++;
+    }
+}
+
+static void
+conn_readable(Server *s, Conn *c)
+{
+    if (bytes_reserve(&c->in, READ_CHUNK) < 0) {
+        conn_close(s, c);
+        return;
+    }
+    ssize_t r = recv(c->fd, c->in.data + c->in.len, READ_CHUNK, 0);
+    if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return;
+    if (r <= 0) {
+        conn_close(s, c);
+        return;
+    }
+    c->in.len += (size_t)r;
+    if (conn_process(s, c) < 0)
+        conn_close(s, c);
+}
+
+/* reply() 로 온 응답을 해당 연결에 붙인다. 연결이 이미 닫혔으면 버린다. */
+static void
+server_wake(Server *s)
+{
+    uint64_t n;
+    if (read(s->wake_fd, &n, sizeof(n)) < 0 && errno != EAGAIN)
+        return;
+    pthread_mutex_lock(&s->lock);
+    Reply *r = s->replies;
+    s->replies = NULL;
+    pthread_mutex_unlock(&s->lock);
+
+    while (r != NULL) {
+        Reply *next = r->next;
+        Conn *c = conn_find(s, r->token);
+        if (c != NULL && c->waiting) {
+            c->waiting = 0;
+            c->closing = r->close || !c->keep;
+            if (conn_respond(c, r->data, r->len) < 0 || conn_process(s, c) < 0)
+                conn_close(s, c);
+        }
+        free(r->data);
+        free(r);
+        r = next;
+    }
+}
+
+static void
+server_loop(Server *s)
+{
+    struct epoll_event events[256];
+    while (!s->stopping) {
+        int n = epoll_wait(s->epoll_fd, events, 256, -1);
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == s->listen_fd) {
+                server_accept(s);
+                continue;
+            }
+            if (fd == s->wake_fd) {
+                server_wake(s);
+                continue;
+            }
+            Conn *c = fd < s->conn_cap ? s->conns[fd] : NULL;
+            if (c == NULL)
+                continue;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                conn_close(s, c);
+                continue;
+            }
+            if (events[i].events & EPOLLOUT && conn_flush(s, c) < 0) {
+                conn_close(s, c);
+                continue;
+            }
+            if (events[i].events & EPOLLIN)
+                conn_readable(s, c);
+        }
+    }
+}
+
+/* ---- Python API */
+
+static void
+server_notify(Server *s)
+{
+    uint64_t one = 1;
+    ssize_t rc = write(s->wake_fd, &one, sizeof(one));
+    (void)rc; /* 카운터가 가득 찼어도 이미 깨어날 것이다 */
+}
+
+static int
+server_init(Server *self, PyObject *args, PyObject *kwargs)
+{
+    static char *kwlist[] = {"host", "port", "backlog", "max_body", "reuse_port", NULL};
+    const char *host = "0.0.0.0";
+    int port = 8000, backlog = 1024, reuse_port = 0;
+    Py_ssize_t max_body = 64 * 1024;
+    struct sockaddr_in addr = {.sin_family = AF_INET};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|sinnp", kwlist, &host, &port, &backlog,
+                                     &max_body, &reuse_port))
+        return -1;
+    if (self->listen_fd >= 0) {
+        PyErr_SetString(PyExc_RuntimeError, "Server already initialized");
+        return -1;
+    }
+    if (port < 0 || port > 65535 || max_body < 0) {
+        PyErr_SetString(PyExc_ValueError, "invalid port or max_body");
+        return -1;
+    }
+    addr.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, *host ? host : "0.0.0.0", &addr.sin_addr) != 1) {
+        PyErr_Format(PyExc_ValueError, "invalid IPv4 host: %s", host);
+        return -1;
+    }
+    self->max_body = (size_t)max_body;
+
+    int one = 1;
+    self->listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (self->listen_fd < 0 ||
+        setsockopt(self->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0 ||
+        (reuse_port && /* pre-fork 워커끼리 같은 포트, 커널이 연결을 나눈다 */
+         setsockopt(self->listen_fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0) ||
+        bind(self->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(self->listen_fd, backlog) < 0 ||
+        (self->epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0 ||
+        (self->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+        PyErr_SetFromErrno(PyExc_OSError);
+        return -1;
+    }
+    struct epoll_event ev = {.events = EPOLLIN, .data.fd = self->listen_fd};
+    struct epoll_event wake = {.events = EPOLLIN, .data.fd = self->wake_fd};
+    if (epoll_ctl(self->epoll_fd, EPOLL_CTL_ADD, self->listen_fd, &ev) < 0 ||
+        epoll_ctl(self->epoll_fd, EPOLL_CTL_ADD, self->wake_fd, &wake) < 0) {
+        PyErr_SetFromErrno(PyExc_OSError);
+        return -1;
+    }
+    if ((self->users = malloc(sizeof(char *) * USER_LIMIT)) == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    return 0;
+}
+
+static PyObject *
+server_new(PyTypeObject *type, PyObject *Py_UNUSED(args), PyObject *Py_UNUSED(kwargs))
+{
+    Server *self = (Server *)type->tp_alloc(type, 0);
+    if (self == NULL)
+        return NULL;
+    self->listen_fd = self->epoll_fd = self->wake_fd = -1;
+    self->rng = 0x9E3779B97F4A7C15ull ^ (uint64_t)(uintptr_t)self;
+    pthread_mutex_init(&self->lock, NULL);
+    pthread_cond_init(&self->ready, NULL);
+    return (PyObject *)self;
+}
+
+static void
+server_dealloc(Server *self)
+{
+    for (int fd = 0; fd < self->conn_cap; fd++)
+        if (self->conns[fd] != NULL)
+            conn_close(self, self->conns[fd]);
+    free(self->conns);
+    if (self->listen_fd >= 0)
+        close(self->listen_fd);
+    if (self->epoll_fd >= 0)
+        close(self->epoll_fd);
+    if (self->wake_fd >= 0)
+        close(self->wake_fd);
+    table_free(self->table);
+    while (self->pending_head != NULL) {
+        Pending *p = self->pending_head;
+        self->pending_head = p->next;
+        free(p->data);
+        free(p);
+    }
+    while (self->replies != NULL) {
+        Reply *r = self->replies;
+        self->replies = r->next;
+        free(r->data);
+        free(r);
+    }
+    for (size_t i = 0; i < self->user_count; i++)
+        free(self->users[i]);
+    free(self->users);
+    for (int i = 0; i < SEEN_SLOTS; i++)
+        free(self->seen[i]);
+    pthread_mutex_destroy(&self->lock);
+    pthread_cond_destroy(&self->ready);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *
+server_serve_forever(Server *self, PyObject *Py_UNUSED(ignored))
+{
+    if (self->epoll_fd < 0 || self->running) {
+        PyErr_SetString(PyExc_RuntimeError, "Server is not ready or already running");
+        return NULL;
+    }
+    self->running = 1;
+    Py_BEGIN_ALLOW_THREADS
+    server_loop(self);
+    Py_END_ALLOW_THREADS
+    self->running = 0;
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+server_stop(Server *self, PyObject *Py_UNUSED(ignored))
+{
+    pthread_mutex_lock(&self->lock);
+    self->stopping = 1;
+    pthread_cond_broadcast(&self->ready);
+    pthread_mutex_unlock(&self->lock);
+    if (self->wake_fd >= 0)
+        server_notify(self);
+    Py_RETURN_NONE;
+}
+
+/* {key: (bodies, track)} -> Table. body 마다 HTTP 응답 전체를 만들어 둔다. */
+static Table *
+table_build(PyObject *table)
+{
+    PyObject *key, *value;
+    Py_ssize_t pos = 0;
+    Table *t = calloc(1, sizeof(Table));
+    if (t == NULL || (t->routes = calloc((size_t)PyDict_GET_SIZE(table) + 1, sizeof(Route))) == NULL)
+        goto nomem;
+
+    while (PyDict_Next(table, &pos, &key, &value)) {
+        PyObject *bodies, *seq = NULL;
+        int track;
+        Py_ssize_t key_len;
+        const char *k = PyUnicode_AsUTF8AndSize(key, &key_len);
+        if (k == NULL)
+            goto fail;
+        if (!PyArg_ParseTuple(value, "Op;table value must be (bodies, track)", &bodies, &track) ||
+            (seq = PySequence_Fast(bodies, "bodies must be a sequence")) == NULL)
+            goto fail;
+        Py_ssize_t count = PySequence_Fast_GET_SIZE(seq);
+        if (count == 0) { /* 없으면 Python 으로 */
+            Py_DECREF(seq);
+            continue;
+        }
+        Route *r = &t->routes[t->count++];
+        r->track = track;
+        r->key = malloc((size_t)key_len);
+        r->responses = calloc((size_t)count, sizeof(Bytes));
+        if (r->key == NULL || r->responses == NULL) {
+            Py_DECREF(seq);
+            goto nomem;
+        }
+        memcpy(r->key, k, (size_t)key_len);
+        r->key_len = (size_t)key_len;
+        for (Py_ssize_t i = 0; i < count; i++) {
+            Py_buffer view;
+            char head[128];
+            if (PyObject_GetBuffer(PySequence_Fast_GET_ITEM(seq, i), &view, PyBUF_SIMPLE) < 0) {
+                Py_DECREF(seq);
+                goto fail;
+            }
+            int n = snprintf(head, sizeof(head),
+                             "HTTP/1.1 200 OK\r\ncontent-length: %zd\r\n"
+                             "content-type: application/json\r\n\r\n",
+                             view.len);
+            int err = bytes_put(&r->responses[i], head, (size_t)n) < 0 ||
+                      bytes_put(&r->responses[i], view.buf, (size_t)view.len) < 0;
+            PyBuffer_Release(&view);
+            r->count = i + 1;
+            if (err) {
+                Py_DECREF(seq);
+                goto nomem;
+            }
+        }
+        Py_DECREF(seq);
+    }
+    return t;
+
+nomem:
+    PyErr_NoMemory();
+fail:
+    table_free(t);
+    return NULL;
+}
+
+static PyObject *
+server_publish(Server *self, PyObject *table)
+{
+    if (!PyDict_Check(table)) {
+        PyErr_SetString(PyExc_TypeError, "publish() expects a dict");
+        return NULL;
+    }
+    Table *t = table_build(table);
+    if (t == NULL)
+        return NULL;
+    pthread_mutex_lock(&self->lock);
+    Table *old = self->table;
+    self->table = t;
+    pthread_mutex_unlock(&self->lock);
+    table_free(old);
+    Py_RETURN_NONE;
+}
+
+/* 요청 head -> (method, target, [(name, value), ...]), name 은 소문자 */
+static PyObject *
+parse_head(const char *s, size_t n)
+{
+    const char *end = s + n - 2; /* 마지막 빈 줄 */
+    const char *eol = memmem(s, n, "\r\n", 2);
+    const char *sp1 = memchr(s, ' ', (size_t)(eol - s));
+    const char *sp2 = memchr(sp1 + 1, ' ', (size_t)(eol - sp1 - 1));
+    PyObject *headers = PyList_New(0);
+    if (headers == NULL)
+        return NULL;
+
+    for (const char *line = eol + 2; line < end; line = eol + 2) {
+        eol = memmem(line, (size_t)(end + 2 - line), "\r\n", 2);
+        const char *colon = memchr(line, ':', (size_t)(eol - line));
+        const char *v = colon + 1, *v_end = eol;
+        while (v < v_end && (*v == ' ' || *v == '\t'))
+            v++;
+        while (v_end > v && (v_end[-1] == ' ' || v_end[-1] == '\t'))
+            v_end--;
+        PyObject *name = PyBytes_FromStringAndSize(line, colon - line);
+        if (name == NULL)
+            goto fail;
+        char *p = PyBytes_AS_STRING(name);
+        for (Py_ssize_t i = 0; i < PyBytes_GET_SIZE(name); i++)
+            p[i] = (char)lower((unsigned char)p[i]);
+        PyObject *pair = Py_BuildValue("(Ny#)", name, v, (Py_ssize_t)(v_end - v));
+        int err = pair == NULL || PyList_Append(headers, pair) < 0;
+        Py_XDECREF(pair);
+        if (err)
+            goto fail;
+    }
+    return Py_BuildValue("(s#y#N)", s, (Py_ssize_t)(sp1 - s), sp1 + 1,
+                         (Py_ssize_t)(sp2 - sp1 - 1), headers);
+
+fail:
+    Py_DECREF(headers);
+    return NULL;
+}
+
+static PyObject *
+server_next(Server *self, PyObject *args)
+{
+    PyObject *arg = Py_None;
+    double timeout = -1.0; /* None: 올 때까지 */
+    Pending *p = NULL;
+    if (!PyArg_ParseTuple(args, "|O", &arg))
+        return NULL;
+    if (arg != Py_None) {
+        timeout = PyFloat_AsDouble(arg);
+        if (timeout == -1.0 && PyErr_Occurred())
+            return NULL;
+        if (timeout < 0)
+            timeout = 0;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    if (timeout >= 0) {
+        deadline.tv_sec += (time_t)timeout;
+        deadline.tv_nsec += (long)((timeout - (double)(time_t)timeout) * 1e9);
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+    pthread_mutex_lock(&self->lock);
+    while (self->pending_head == NULL && !self->stopping) {
+        if (timeout < 0)
+            pthread_cond_wait(&self->ready, &self->lock);
+        else if (pthread_cond_timedwait(&self->ready, &self->lock, &deadline) != 0)
+            break;
+    }
+    if ((p = self->pending_head) != NULL) {
+        self->pending_head = p->next;
+        if (self->pending_head == NULL)
+            self->pending_tail = NULL;
+        self->pending_count--;
+    }
+    pthread_mutex_unlock(&self->lock);
+    Py_END_ALLOW_THREADS
+
+    if (p == NULL)
+        Py_RETURN_NONE;
+    PyObject *head = parse_head(p->data, p->head_len);
+    PyObject *res = head == NULL ? NULL
+                                 : Py_BuildValue("(KNy#)", (unsigned long long)p->token, head,
+                                                 p->data + p->head_len, (Py_ssize_t)p->body_len);
+    free(p->data);
+    free(p);
+    return res;
+}
+
+static PyObject *
+server_reply(Server *self, PyObject *args, PyObject *kwargs)
+{
+    static char *kwlist[] = {"token", "response", "close", NULL};
+    unsigned long long token;
+    Py_buffer view;
+    int close_after = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "Ky*|p", kwlist, &token, &view, &close_after))
+        return NULL;
+
+    Reply *r = malloc(sizeof(Reply));
+    if (r == NULL || (r->data = malloc((size_t)view.len + 1)) == NULL) {
+        free(r);
+        PyBuffer_Release(&view);
+        return PyErr_NoMemory();
+    }
+    memcpy(r->data, view.buf, (size_t)view.len);
+    r->len = (size_t)view.len;
+    r->token = token;
+    r->close = close_after;
+    PyBuffer_Release(&view);
+
+    pthread_mutex_lock(&self->lock);
+    r->next = self->replies;
+    self->replies = r;
+    pthread_mutex_unlock(&self->lock);
+    server_notify(self);
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+server_drain_users(Server *self, PyObject *Py_UNUSED(ignored))
+{
+    char **users;
+    size_t count;
+    pthread_mutex_lock(&self->lock);
+    count = self->user_count;
+    users = malloc(sizeof(char *) * (count ? count : 1));
+    if (users != NULL) {
+        memcpy(users, self->users, sizeof(char *) * count);
+        self->user_count = 0;
+    }
+    pthread_mutex_unlock(&self->lock);
+    if (users == NULL)
+        return PyErr_NoMemory();
+
+    PyObject *res = PyList_New((Py_ssize_t)count);
+    for (size_t i = 0; i < count; i++) {
+        if (res != NULL) {
+            PyObject *user = PyUnicode_DecodeUTF8(users[i], (Py_ssize_t)strlen(users[i]), NULL);
+            if (user == NULL)
+                Py_CLEAR(res);
+            else
+                PyList_SET_ITEM(res, (Py_ssize_t)i, user);
+        }
+        free(users[i]);
+    }
+    free(users);
+    return res;
+}
+
+static PyObject *
+server_stats(Server *self, PyObject *Py_UNUSED(ignored))
+{
+    Py_ssize_t routes;
+    size_t pending, users;
+    pthread_mutex_lock(&self->lock);
+    routes = self->table ? self->table->count : 0;
+    pending = self->pending_count;
+    users = self->user_count;
+    pthread_mutex_unlock(&self->lock);
+    return Py_BuildValue("{sKsKsKsKsKsnsnsnsK}", "connections", self->connections, "requests",
+                         self->requests, "native", self->native, "fallback", self->fallback,
+                         "rejected", self->rejected, "routes", routes, "pending",
+                         (Py_ssize_t)pending, "users", (Py_ssize_t)users, "dropped_users",
+                         self->dropped_users);
+}
+
+static PyMethodDef server_methods[] = {
+    {"serve_forever", (PyCFunction)server_serve_forever, METH_NOARGS,
+     "serve_forever(): stop() 까지 GIL 없이 epoll 루프를 돈다."},
+    {"stop", (PyCFunction)server_stop, METH_NOARGS, "stop()"},
+    {"publish", (PyCFunction)server_publish, METH_O,
+     "publish({key: (bodies, track)}): 응답 표를 통째로 바꾼다."},
+    {"next", (PyCFunction)server_next, METH_VARARGS,
+     "next(timeout=None) -> (token, (method, target, headers), body) | None"},
+    {"reply", (PyCFunction)(void (*)(void))server_reply, METH_VARARGS | METH_KEYWORDS,
+     "reply(token, response, close=False): next() 로 받은 요청의 HTTP 응답 전체"},
+    {"drain_users", (PyCFunction)server_drain_users, METH_NOARGS,
+     "drain_users() -> [user_id, ...]"},
+    {"stats", (PyCFunction)server_stats, METH_NOARGS, "stats() -> dict"},
+    {NULL, NULL, 0, NULL},
+};
+
+static PyTypeObject ServerType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "ajou_native.Server",
+    .tp_basicsize = sizeof(Server),
+    .tp_dealloc = (destructor)server_dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "epoll HTTP/1.1 front-end (Server(host, port, backlog, max_body, reuse_port))",
+    .tp_methods = server_methods,
+    .tp_init = (initproc)server_init,
+    .tp_new = server_new,
+};
+
+/* ------------------------------------------------------ shared snapshot */
+
+/*
+ * 여러 프로세스가 같이 mmap 한 버퍼에 writer 하나가 payload 를 통째로 쓰고,
+ * reader 들은 lock 없이 읽는다. (seqlock: 쓰는 동안 seq 가 홀수)
+ *     [uint64 seq][uint64 len][payload ...]
+ * writer 가 쓰다가 죽으면 seq 가 홀수로 남으므로, 새 writer 를 띄우기 전에
+ * snapshot_reset() 으로 다음 짝수 + 빈 payload 로 돌린다. reader 는 SNAPSHOT_SPINS 번
+ * 안에 일관된 값을 못 읽으면 None (다음 poll 에 다시) 을 돌려준다.
+ */
+
+#define SNAPSHOT_SPINS 4096
+
+typedef struct {
+    uint64_t seq;
+    uint64_t len;
+} SnapshotHead;
+
+static int
+snapshot_view(PyObject *arg, Py_buffer *view, int writable)
+{
+    if (PyObject_GetBuffer(arg, view, writable ? PyBUF_WRITABLE : PyBUF_SIMPLE) < 0)
+        return -1;
+    if ((size_t)view->len < sizeof(SnapshotHead) ||
+        ((uintptr_t)view->buf % _Alignof(SnapshotHead)) != 0) {
+        PyBuffer_Release(view);
+        PyErr_SetString(PyExc_ValueError, "snapshot buffer too small or unaligned");
+        return -1;
+    }
+    return 0;
+}
+
+static PyObject *
+snapshot_write(PyObject *Py_UNUSED(self), PyObject *args)
+{
+    PyObject *target;
+    Py_buffer shm, data;
+    if (!PyArg_ParseTuple(args, "Oy*", &target, &data))
+        return NULL;
+    if (snapshot_view(target, &shm, 1) < 0) {
+        PyBuffer_Release(&data);
+        return NULL;
+    }
+    SnapshotHead *head = shm.buf;
+    PyObject *res = NULL;
+    if ((size_t)data.len > (size_t)shm.len - sizeof(SnapshotHead)) {
+        PyErr_Format(PyExc_ValueError, "snapshot of %zd bytes does not fit", data.len);
+        goto done;
+    }
+
+    uint64_t seq = __atomic_load_n(&head->seq, __ATOMIC_RELAXED);
+    seq = (seq + 1) & ~(uint64_t)1; /* reset 없이 홀수로 남아 있어도 짝수에서 시작 */
+    __atomic_store_n(&head->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(head + 1, data.buf, (size_t)data.len);
+    __atomic_store_n(&head->len, (uint64_t)data.len, __ATOMIC_RELAXED);
+    __atomic_store_n(&head->seq, seq + 2, __ATOMIC_RELEASE);
+    res = PyLong_FromUnsignedLongLong(seq + 2);
+
+done:
+    PyBuffer_Release(&shm);
+    PyBuffer_Release(&data);
+    return res;
+}
+
+static PyObject *
+snapshot_reset(PyObject *Py_UNUSED(self), PyObject *arg)
+{
+    Py_buffer shm;
+    if (snapshot_view(arg, &shm, 1) < 0)
+        return NULL;
+    SnapshotHead *head = shm.buf;
+    uint64_t seq = __atomic_load_n(&head->seq, __ATOMIC_RELAXED);
+    seq = (seq + 2) & ~(uint64_t)1; /* 지금 값과 다른 다음 짝수: reader 가 빈 표를 본다 */
+    __atomic_store_n(&head->len, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&head->seq, seq, __ATOMIC_RELEASE);
+    PyBuffer_Release(&shm);
+    return PyLong_FromUnsignedLongLong(seq);
+}
+
+static PyObject *
+snapshot_read(PyObject *Py_UNUSED(self), PyObject *args)
+{
+    PyObject *target;
+    unsigned long long last = 0;
+    Py_buffer shm;
+    if (!PyArg_ParseTuple(args, "O|K", &target, &last))
+        return NULL;
+    if (snapshot_view(target, &shm, 0) < 0)
+        return NULL;
+    SnapshotHead *head = shm.buf;
+    size_t capacity = (size_t)shm.len - sizeof(SnapshotHead);
+    PyObject *res = NULL, *payload = NULL;
+
+    for (int spin = 0;; spin++) {
+        if (spin == SNAPSHOT_SPINS) { /* writer 가 멈췄거나 죽었다 */
+            res = Py_NewRef(Py_None);
+            break;
+        }
+        if (spin > 0)
+            sched_yield();
+        uint64_t seq = __atomic_load_n(&head->seq, __ATOMIC_ACQUIRE);
+        if (seq == last) { /* 바뀌지 않았다 (0 = 아직 안 썼다) */
+            res = Py_NewRef(Py_None);
+            break;
+        }
+        if (seq & 1)
+            continue; /* 쓰는 중 */
+        uint64_t len = __atomic_load_n(&head->len, __ATOMIC_RELAXED);
+        if (len > capacity)
+            continue; /* seq 를 다시 읽으면 바뀌어 있다 */
+        if (payload == NULL || (uint64_t)PyBytes_GET_SIZE(payload) != len) {
+            Py_XDECREF(payload);
+            if ((payload = PyBytes_FromStringAndSize(NULL, (Py_ssize_t)len)) == NULL)
+                break;
+        }
+        memcpy(PyBytes_AS_STRING(payload), head + 1, (size_t)len);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&head->seq, __ATOMIC_RELAXED) == seq) {
+            res = Py_BuildValue("(KO)", (unsigned long long)seq, payload);
+            break;
+        }
+    }
+    Py_XDECREF(payload);
+    PyBuffer_Release(&shm);
+    return res;
+}
+
+#endif /* __linux__ */
+
+/* ---------------------------------------------------------------- module */
+
+static PyMethodDef native_methods[] = {
+    {"scan_notices", scan_notices, METH_O,
+     "scan_notices(html) -> [(id, title, date, writer, href, category), ...]"},
+    {"json_field", (PyCFunction)(void (*)(void))json_field, METH_VARARGS | METH_KEYWORDS,
+     "json_field(text, limit=0, strip=None) -> JSON string bytes"},
+    {"build_card", (PyCFunction)(void (*)(void))build_card, METH_VARARGS | METH_KEYWORDS,
+     "build_card(title, date, link, writer, put_date=False) -> list card bytes"},
+    {"to_day", to_day, METH_O, "to_day(text) -> date.toordinal() | 0"},
+    {"scan_batch", scan_batch, METH_VARARGS,
+     "scan_batch(html, address) -> NoticeBatch"},
+    {"load_batch", load_batch, METH_O, "load_batch(data) -> NoticeBatch (batch.dump())"},
+    {"skim_skill", skim_skill, METH_O,
+     "skim_skill(body) -> (user_id, params, utterance) | None"},
+#ifdef __linux__
+    {"snapshot_write", snapshot_write, METH_VARARGS, "snapshot_write(shm, payload) -> seq"},
+    {"snapshot_reset", snapshot_reset, METH_O,
+     "snapshot_reset(shm) -> seq: 죽은 writer 가 남긴 홀수 seq 를 빈 payload 로 되돌린다."},
+    {"snapshot_read", snapshot_read, METH_VARARGS,
+     "snapshot_read(shm, last_seq=0) -> (seq, payload) | None"},
+#endif
+    {NULL, NULL, 0, NULL},
+};
+
+static struct PyModuleDef native_module = {
+    PyModuleDef_HEAD_INIT, "ajou_native", "아주대 공지 네이티브 헬퍼", -1, native_methods,
+    NULL, NULL, NULL, NULL,
+};
+
+PyMODINIT_FUNC
+PyInit_ajou_native(void)
+{
+    if (PyType_Ready(&NoticeBatchType) < 0)
+        return NULL;
+    PyObject *module = PyModule_Create(&native_module);
+    if (module == NULL)
+        return NULL;
+    Py_INCREF(&NoticeBatchType);
+    if (PyModule_AddObject(module, "NoticeBatch", (PyObject *)&NoticeBatchType) < 0) {
+        Py_DECREF(&NoticeBatchType);
+        Py_DECREF(module);
+        return NULL;
+    }
+#ifdef __linux__
+    if (PyType_Ready(&ServerType) < 0) {
+        Py_DECREF(module);
+        return NULL;
+    }
+    Py_INCREF(&ServerType);
+    if (PyModule_AddObject(module, "Server", (PyObject *)&ServerType) < 0) {
+        Py_DECREF(&ServerType);
+        Py_DECREF(module);
+        return NULL;
+    }
+#endif
+    return module;
+}
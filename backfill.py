@@ -0,0 +1,202 @@
+"""article.offset backfill
+
+poll 과 crawler 는 처음 몇 쪽만 보므로, 그보다 오래된 공지는 여기서 채운다.
+진행 상황은 ajou_crawl_checkpoint 에 공지와 같은 트랜잭션으로 남기므로, 중간에
+멈춰도 다음 run() 이 그 offset 부터 이어서 읽는다.
+
+1) 처음 (complete 가 아직 False)
+   offset 을 stride (articleLimit) 씩 늘리며 목록 끝 (빈 쪽) 까지 읽는다.
+   run() 한 번에 pages 쪽까지만 읽고 다음 interval 에 이어 간다.
+   offset 0 쪽의 가장 큰 id 를 checkpoint 의 newest_id 로 남긴다.
+2) 그 다음 (complete)
+   offset 0 부터 step 개로 시작해서 쪽마다 두 배 (stride 까지) 로 읽다가, newest_id
+   이하인 id 가 나오면 멈추고 newest_id 를 이번에 본 가장 큰 id 로 올린다.
+   poll 과 crawler 가 새 공지의 앞쪽을 먼저 저장해도 (이미 저장된 id 에서 멈추면
+   그 아래가 빈다) newest_id 까지는 끝까지 읽는다. 평소에는 작은 쪽 하나로 끝난다.
+   중간에 실패하면 아무것도 저장하지 않는다. (newest_id 도 그대로)
+   pages 쪽 안에 닿지 못하면 거기서부터 다시 1) 로 이어 간다.
+
+쪽을 읽는 사이에 새 공지가 올라오면 offset 이 밀려서 몇 개를 다시 읽지만,
+id 로 건너뛰므로 중복 저장은 없다.
+
+환경 변수
+    AJOU_BACKFILL_INTERVAL  실행 간격(초) (default 1800, 0 이면 끔)
+    AJOU_BACKFILL_STRIDE    한 쪽의 articleLimit (default 200)
+    AJOU_BACKFILL_PAGES     run() 한 번에 읽을 최대 쪽 수 (default 20)
+    AJOU_BACKFILL_STEP      complete 이후 첫 쪽의 articleLimit (default 15)
+"""
+
+import os
+import time
+from datetime import datetime
+
+import db_model.crud
+import db_model.database
+
+BACKFILL_INTERVAL = float(os.environ.get("AJOU_BACKFILL_INTERVAL", 1800.0))
+BACKFILL_STRIDE = int(os.environ.get("AJOU_BACKFILL_STRIDE", 200))
+BACKFILL_PAGES = int(os.environ.get("AJOU_BACKFILL_PAGES", 20))
+BACKFILL_STEP = int(os.environ.get("AJOU_BACKFILL_STEP", 15))
+
+
+class Backfill:
+    """
+    parse(url) 는 List[Notice] (빈 쪽은 []) | 실패면 parser.Error (Ajou.crawlPage),
+    build(offset, limit) 는 그 쪽의 URL (Ajou.pageUrl)
+
+    Methods
+    -------
+    maybe_run() -> int
+    run() -> int
+    stats() -> dict
+    """
+
+    __slots__ = (
+        "parse",
+        "build",
+        "name",
+        "stride",
+        "pages",
+        "step",
+        "interval",
+        "last_run",
+        "runs",
+        "fetched",
+        "created",
+        "last_created",
+        "offset",
+        "complete",
+        "failures",
+    )
+
+    def __init__(
+        self,
+        parse,
+        build,
+        name="notices",
+        stride=BACKFILL_STRIDE,
+        pages=BACKFILL_PAGES,
+        step=BACKFILL_STEP,
+        interval=BACKFILL_INTERVAL,
+    ):
+        self.parse = parse
+        self.build = build
+        self.name = name  # ajou_crawl_checkpoint.name
+        self.stride = stride
+        self.pages = pages
+        self.step = min(step, stride)
+        self.interval = interval
+        self.last_run = None  # time.monotonic()
+        self.runs = 0
+        self.fetched = 0  # 읽은 쪽 수
+        self.created = 0  # 지금까지 새로 저장한 공지 수
+        self.last_created = 0
+        self.offset = None  # 마지막으로 본 checkpoint
+        self.complete = None
+        self.failures = 0
+
+    def maybe_run(self):
+        if self.interval <= 0:
+            return 0
+        if (
+            self.last_run is not None
+            and time.monotonic() - self.last_run < self.interval
+        ):
+            return 0
+        return self.run()
+
+    def run(self):
+        """checkpoint 에 따라 이어서 읽거나 새 공지만 읽는다. 새로 넣은 공지 수"""
+        created = 0
+        try:
+            with db_model.database.SessionLocal() as db:
+                checkpoint = db_model.crud.get_checkpoint(db, self.name)
+                if checkpoint.complete:
+                    created = self._incremental(db, checkpoint)
+                else:
+                    created = self._backfill(db, checkpoint)
+                self.offset, self.complete = checkpoint.offset, checkpoint.complete
+        except Exception as e:  # 다음 interval 에 다시 (읽은 쪽은 이미 commit)
+            self.failures += 1
+            print(f"Backfill failed: {e}")
+
+        self.last_run = time.monotonic()
+        self.runs += 1
+        self.created += created
+        self.last_created = created
+        return created
+
+    def _page(self, offset, limit):
+        self.fetched += 1
+        notices = self.parse(self.build(offset, limit))
+        if not isinstance(notices, list):
+            self.failures += 1
+            return None
+        return notices
+
+    def _backfill(self, db, checkpoint):
+        created = 0
+        for _ in range(self.pages):
+            notices = self._page(checkpoint.offset, self.stride)
+            if notices is None:
+                break  # 같은 offset 부터 다시
+
+            if notices and checkpoint.offset == 0:
+                checkpoint.newest_id = max(notice.id for notice in notices)
+            if notices:
+                checkpoint.offset += self.stride
+            else:  # 목록 끝
+                checkpoint.offset, checkpoint.complete = 0, True
+            checkpoint.updated_at = datetime.now()
+            created += db_model.crud.create_notices(db=db, notices=notices)
+            db.commit()  # 공지가 없으면 create_notices 는 commit 하지 않는다
+            if checkpoint.complete:
+                print(f"Backfill reached the end ({self.fetched} pages)")
+                break
+        return created
+
+    def _incremental(self, db, checkpoint):
+        found = {}
+        offset, limit = 0, self.step
+        reached = False
+        for _ in range(self.pages):
+            notices = self._page(offset, limit)
+            if notices is None:
+                return 0  # 앞쪽만 저장하지 않는다
+
+            for notice in notices:
+                found.setdefault(notice.id, notice)
+            offset += limit
+            if not notices or self._reached(db, checkpoint, notices):
+                reached = True  # 지난 run 이 읽은 곳까지 왔다
+                break
+            limit = min(limit * 2, self.stride)
+
+        if not reached:  # pages 쪽 안에 못 닿았으면 남은 곳은 1) 처럼 이어서 읽는다
+            checkpoint.offset, checkpoint.complete = offset, False
+        if found:  # 그 아래는 다 읽었다 (못 닿았으면 1) 이 목록 끝까지 읽는다)
+            checkpoint.newest_id = max(checkpoint.newest_id or 0, max(found))
+        checkpoint.updated_at = datetime.now()
+        created = db_model.crud.create_notices(db=db, notices=list(found.values()))
+        db.commit()
+        return created
+
+    @staticmethod
+    def _reached(db, checkpoint, notices):
+        if (
+            checkpoint.newest_id is None
+        ):  # newest_id 가 없던 checkpoint 는 한 번만 예전처럼
+            ids = [notice.id for notice in notices]
+            return bool(db_model.crud.stored_notice_ids(db, ids))
+        return any(notice.id <= checkpoint.newest_id for notice in notices)
+
+    def stats(self):
+        return {
+            "runs": self.runs,
+            "fetched": self.fetched,
+            "created": self.created,
+            "last_created": self.last_created,
+            "offset": self.offset,
+            "complete": self.complete,
+            "failures": self.failures,
+        }
@@ -0,0 +1,94 @@
+"""공지 id -> 완성된 리스트 카드 bytes
+
+같은 공지가 유저마다, 엔드포인트마다 Ktemplate.buildCard 를 다시 거치지 않도록
+카드 조각을 만들어 두고 응답은 이어 붙이기만 한다. (DB 에서 읽은 공지)
+putDate 가 있는/없는 두 가지를 같이 저장한다.
+
+제목, 작성자, 날짜, 링크 중 하나라도 바뀌면 (홈페이지에서 제목 수정 등)
+그 id 의 카드를 다시 만든다.
+
+환경 변수
+    AJOU_CARD_CACHE_SIZE  최대 공지 수 (default 2048)
+"""
+
+import os
+import threading
+from collections import OrderedDict
+
+from json_model import Ktemplate
+
+CARD_CACHE_SIZE = int(os.environ.get("AJOU_CARD_CACHE_SIZE", 2048))
+
+
+class _Cards:
+    __slots__ = ("key", "plain", "dated")
+
+    def __init__(self, key, plain, dated):
+        self.key = key  # (title, date, link, writer)
+        self.plain = plain
+        self.dated = dated
+
+
+class CardCache:
+    """
+    Methods
+    -------
+    card(id, title, date, link, writer, putDate=False) -> bytes
+    invalidate(id=None)
+    stats() -> dict
+    """
+
+    __slots__ = ("maxsize", "_cards", "_lock", "hits", "builds", "changed")
+
+    def __init__(self, maxsize=CARD_CACHE_SIZE):
+        self.maxsize = maxsize
+        self._cards = OrderedDict()
+        self._lock = threading.Lock()
+        self.hits = self.builds = self.changed = 0
+
+    def card(self, id, title, date, link, writer, putDate=False):
+        id = str(id)  # 홈페이지는 str, DB 는 int
+        key = (title, date, link, writer)
+        with self._lock:
+            cards = self._cards.get(id)
+            if cards is not None and cards.key == key:
+                self.hits += 1
+                self._cards.move_to_end(id)
+                return cards.dated if putDate else cards.plain
+
+        cards = self._build(id, key)
+        return cards.dated if putDate else cards.plain
+
+    def _build(self, id, key):
+        title, date, link, writer = key
+        cards = _Cards(
+            key,
+            Ktemplate.buildCard(id, title, date, link, writer),
+            Ktemplate.buildCard(id, title, date, link, writer, True),
+        )
+        with self._lock:
+            old = self._cards.get(id)
+            self.builds += 1
+            if old is not None and old.key != key:
+                self.changed += 1  # 제목/작성자 수정
+            self._cards[id] = cards
+            self._cards.move_to_end(id)
+            while len(self._cards) > self.maxsize:
+                self._cards.popitem(last=False)
+        return cards
+
+    def invalidate(self, id=None):
+        with self._lock:
+            if id is None:
+                self._cards.clear()
+            else:
+                self._cards.pop(id, None)
+
+    def stats(self):
+        with self._lock:
+            return {
+                "size": len(self._cards),
+                "hits": self.hits,
+                "builds": self.builds,
+                "changed": self.changed,
+            }
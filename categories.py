@@ -0,0 +1,23 @@
+"""공지 카테고리
+
+카카오 cate 값 -> 홈페이지 srCategoryId. ingest (parser.NoticeFilter, crawler) 와
+read model, /ask/filter 가 모두 이 표 하나를 쓴다.
+"""
+
+CATEGORIES = {
+    "학사": 1,
+    "학사일정": 168,
+    "비교과": 2,
+    "장학": 3,
+    "취업": 6,
+    "사무": 7,
+    "행사": 166,
+    "파란학기제": 167,
+    "파란학기": 167,
+    "학술": 4,
+    "입학": 5,
+    "기타": 8,
+}
+
+# 불러올 목록 (파란학기/파란학기제는 같은 id 라 한 번)
+CATEGORY_IDS = sorted(set(CATEGORIES.values()))
@@ -0,0 +1,207 @@
+"""전체 카테고리 크롤러
+
+Ajou.run 의 poll 은 필터 없는 첫 쪽만 보므로, interval 마다 모든 카테고리의 처음
+pages 쪽을 한꺼번에 불러와서 id 로 합친 뒤 한 트랜잭션으로 저장한다.
+(이미 있는 id 는 create_notices 가 건너뛴다)
+
+요청은 workers 개의 스레드가 나눠서 보내고, 같은 호스트에는 동시에 per_host 개,
+요청 시작 사이에 gap 초 이상을 둔다. 그래서 전체 시간은 한 쪽을 불러오는 시간의
+ceil(쪽 수 / per_host) 배 정도다. 홈페이지에 부담을 주지 않도록 per_host 는 작게
+두고, 늘리면 그 호스트의 http_pool 도 per_host 개까지 연결하게 늘린다.
+
+환경 변수
+    AJOU_CRAWL_INTERVAL  실행 간격(초) (default 3600, 0 이면 끔)
+    AJOU_CRAWL_PAGES     카테고리마다 불러올 쪽 수 (default 1)
+    AJOU_CRAWL_WORKERS   스레드 수 (default 12)
+    AJOU_CRAWL_PER_HOST  호스트당 동시 요청 수 (default 4)
+    AJOU_CRAWL_GAP       같은 호스트 요청 시작 간격(초) (default 0.05)
+"""
+
+import os
+import threading
+import time
+from concurrent.futures import ThreadPoolExecutor
+from contextlib import contextmanager
+from urllib.error import URLError
+from urllib.parse import urlsplit
+
+import db_model.crud
+import db_model.database
+from http_pool import get_pool
+
+CRAWL_INTERVAL = float(os.environ.get("AJOU_CRAWL_INTERVAL", 3600.0))
+CRAWL_PAGES = int(os.environ.get("AJOU_CRAWL_PAGES", 1))
+CRAWL_WORKERS = int(os.environ.get("AJOU_CRAWL_WORKERS", 12))
+CRAWL_PER_HOST = int(os.environ.get("AJOU_CRAWL_PER_HOST", 4))
+CRAWL_GAP = float(os.environ.get("AJOU_CRAWL_GAP", 0.05))
+
+
+class _Host:
+    __slots__ = ("slots", "next")
+
+    def __init__(self, limit):
+        self.slots = threading.BoundedSemaphore(limit)
+        self.next = 0.0  # 다음 요청을 시작할 수 있는 time.monotonic()
+
+
+class HostLimiter:
+    """
+    호스트마다 동시 요청 수와 요청 시작 간격을 제한한다.
+
+    Usage
+    -----
+        with limiter.slot("www.ajou.ac.kr"):
+            fetch(url)
+    """
+
+    __slots__ = ("limit", "gap", "_hosts", "_lock")
+
+    def __init__(self, limit=CRAWL_PER_HOST, gap=CRAWL_GAP):
+        self.limit = max(1, limit)
+        self.gap = gap
+        self._hosts = {}
+        self._lock = threading.Lock()
+
+    @contextmanager
+    def slot(self, host):
+        with self._lock:
+            state = self._hosts.get(host)
+            if state is None:
+                state = self._hosts[host] = _Host(self.limit)
+
+        with state.slots:
+            with self._lock:
+                now = time.monotonic()
+                start = max(now, state.next)
+                state.next = start + self.gap
+            if start > now:
+                time.sleep(start - now)
+            yield
+
+
+class Crawler:
+    """
+    parse(url) 는 List[Notice] (빈 쪽은 []) | 실패면 parser.Error (Ajou.crawlPage),
+    targets(pages) 는 불러올 URL 목록 (Ajou.crawlTargets)
+
+    Methods
+    -------
+    maybe_run() -> int
+    run() -> int
+    crawl() -> List[Notice]
+    stats() -> dict
+    """
+
+    __slots__ = (
+        "parse",
+        "targets",
+        "pages",
+        "workers",
+        "interval",
+        "limiter",
+        "last_run",
+        "runs",
+        "created",
+        "last_pages",
+        "last_notices",
+        "last_created",
+        "last_seconds",
+        "failures",
+    )
+
+    def __init__(
+        self,
+        parse,
+        targets,
+        pages=CRAWL_PAGES,
+        workers=CRAWL_WORKERS,
+        interval=CRAWL_INTERVAL,
+        limiter=None,
+    ):
+        self.parse = parse
+        self.targets = targets
+        self.pages = pages
+        self.workers = max(1, workers)
+        self.interval = interval
+        self.limiter = limiter if limiter is not None else HostLimiter()
+        self.last_run = None  # time.monotonic()
+        self.runs = 0
+        self.created = 0  # 지금까지 새로 저장한 공지 수
+        self.last_pages = 0
+        self.last_notices = 0  # 마지막 crawl 에서 합친 (중복 없는) 공지 수
+        self.last_created = 0
+        self.last_seconds = 0.0
+        self.failures = 0  # 불러오지 못한 쪽 수
+
+    def maybe_run(self):
+        if self.interval <= 0:
+            return 0
+        if (
+            self.last_run is not None
+            and time.monotonic() - self.last_run < self.interval
+        ):
+            return 0
+        return self.run()
+
+    def run(self):
+        """crawl() 결과를 저장한다. 새로 넣은 공지 수를 돌려준다."""
+        start = time.perf_counter()
+        notices = self.crawl()
+        created = 0
+        try:
+            with db_model.database.SessionLocal() as db:
+                created = db_model.crud.create_notices(db=db, notices=notices)
+        except Exception as e:  # 다음 interval 에 다시
+            print(f"Crawl failed: {e}")
+
+        self.last_run = time.monotonic()
+        self.runs += 1
+        self.created += created
+        self.last_created = created
+        self.last_seconds = time.perf_counter() - start
+        return created
+
+    def crawl(self):
+        """모든 target 을 병렬로 불러와서 id 로 합친다. (최신 id 부터)"""
+        urls = self.targets(self.pages)
+        with ThreadPoolExecutor(
+            max_workers=min(self.workers, len(urls) or 1), thread_name_prefix="crawl"
+        ) as pool:
+            results = list(pool.map(self._fetch, urls))
+
+        merged = {}
+        for notices in results:
+            if not isinstance(notices, list):  # Error, 다른 쪽은 그대로 합친다
+                self.failures += 1
+                continue
+            for notice in notices:
+                merged.setdefault(notice.id, notice)
+
+        self.last_pages = len(urls)
+        self.last_notices = len(merged)
+        return sorted(merged.values(), key=lambda notice: notice.id, reverse=True)
+
+    def _fetch(self, url):
+        parts = urlsplit(url)
+        # per_host 개가 한꺼번에 가도 연결을 기다리지 않게
+        get_pool(parts.hostname, parts.port or 443, self.limiter.limit)
+        try:
+            with self.limiter.slot(parts.hostname):
+                return self.parse(url)
+        except (
+            URLError,
+            OSError,
+        ) as e:  # Ajou.crawlPage 는 Error 로 돌려준다 (다른 parse 용)
+            print(f"Crawl {url} failed: {e!r}")
+            return None
+
+    def stats(self):
+        return {
+            "runs": self.runs,
+            "created": self.created,
+            "last_pages": self.last_pages,
+            "last_notices": self.last_notices,
+            "last_created": self.last_created,
+            "last_seconds": self.last_seconds,
+            "failures": self.failures,
+        }
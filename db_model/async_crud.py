@@ -0,0 +1,50 @@
+"""crud.py 의 AsyncSession 버전 (FastAPI async 엔드포인트용)"""
+
+from datetime import date
+
+from sqlalchemy import select
+from sqlalchemy.ext.asyncio import AsyncSession
+
+from . import models
+from .crud import NOTICE_CARD_COLUMNS
+
+
+async def get_user_by_user_id(db: AsyncSession, user_id: str):
+    result = await db.execute(
+        select(models.Users).filter(models.Users.user_id == user_id).limit(1)
+    )
+    return result.scalars().first()  # returns None or db object
+
+
+async def create_user(db: AsyncSession, user_id: str):
+    db_user = models.Users(
+        user_id=user_id,
+        last_notice_id=10000,
+    )
+    db.add(db_user)
+    await db.commit()
+    await db.refresh(db_user)
+    return db_user
+
+
+async def update_last_notice(db: AsyncSession, user_id: str, last_notice_id: int):
+    db_user = await get_user_by_user_id(db=db, user_id=user_id)
+    if db_user.last_notice_id < last_notice_id:
+        db_user.last_notice_id = last_notice_id
+        await db.commit()
+        await db.refresh(db_user)
+    return db_user
+
+
+async def get_notices_with_date(db: AsyncSession, date: date):
+    result = await db.execute(
+        select(*NOTICE_CARD_COLUMNS)
+        .filter(models.Notices.date == date)
+        .order_by(models.Notices.id.desc())
+    )
+    return result.all()  # (id, title, date, link, writer) rows, descending order
+
+
+async def get_all_sched(db: AsyncSession):
+    result = await db.execute(select(models.Schedules))
+    return result.scalars().all()
@@ -1,7 +1,19 @@
+from datetime import date, datetime
+
+from sqlalchemy import delete, insert, literal, select
 from sqlalchemy.orm import Session
 
 from . import models
 
+# Ktemplate.buildCard 에 들어가는 열
+NOTICE_CARD_COLUMNS = (
+    models.Notices.id,
+    models.Notices.title,
+    models.Notices.date,
+    models.Notices.link,
+    models.Notices.writer,
+)
+
 
 def get_user_by_user_id(db: Session, user_id: str):
     return (
@@ -9,6 +21,10 @@ def get_user_by_user_id(db: Session, user_id: str):
     )  # returns None or db object
 
 
+def get_all_user_ids(db: Session):
+    return [user_id for (user_id,) in db.query(models.Users.user_id)]
+
+
 def get_user_last_notice(db: Session, user_id: str):
     user = db.query(models.Users).filter(models.Users.user_id == user_id).first()
     return user.last_notice_id
@@ -25,8 +41,22 @@ def create_user(db: Session, user_id: str):
     return db_user
 
 
+def create_users(db: Session, user_ids) -> int:
+    """유저 여러 명을 한 번에 넣는다. (이미 있으면 무시)"""
+    if not user_ids:
+        return 0
+    result = db.execute(
+        insert(models.Users)
+        .values([dict(user_id=user_id, last_notice_id=10000) for user_id in user_ids])
+        .prefix_with("IGNORE", dialect="mysql")
+        .prefix_with("OR IGNORE", dialect="sqlite")
+    )
+    db.commit()
+    return result.rowcount
+
+
 def create_notice(
-    db: Session, id: int, title: str, category: str, date: str, link: str, writer: str
+    db: Session, id: int, title: str, category: str, date: date, link: str, writer: str
 ):
     db_notice = models.Notices(
         id=id, title=title, category=category, date=date, link=link, writer=writer
@@ -37,6 +67,62 @@ def create_notice(
     return db_notice
 
 
+def create_notices(db: Session, notices) -> int:
+    """공지 여러 개를 한 트랜잭션으로 넣는다. (이미 있는 id 는 archive 까지 보고 건너뜀)
+
+    Args:
+        notices: id, title, category, date, link, writer 를 가진 객체 목록 (parser.Notice)
+
+    Returns:
+        새로 넣은 공지 수
+    """
+    if not notices:
+        return 0
+
+    existing = stored_notice_ids(db, [notice.id for notice in notices])
+
+    rows = {}
+    for notice in notices:
+        if notice.id in existing or notice.id in rows:
+            continue
+        rows[notice.id] = dict(
+            id=notice.id,
+            title=notice.title,
+            category=notice.category,
+            date=notice.date,
+            link=notice.link,
+            writer=notice.writer,
+        )
+
+    if rows:
+        # 확인과 insert 사이에 다른 크롤러가 넣었어도 실패하지 않게 IGNORE
+        db.execute(
+            insert(models.Notices)
+            .values(list(rows.values()))
+            .prefix_with("IGNORE", dialect="mysql")
+            .prefix_with("OR IGNORE", dialect="sqlite")
+        )
+    db.commit()
+    return len(rows)
+
+
+def stored_notice_ids(db: Session, ids) -> set:
+    """ids 중 이미 저장된 id (retention 이 archive 로 옮긴 것도 포함)"""
+    if not ids:
+        return set()
+    ids = list(ids)
+    existing = {
+        id for (id,) in db.query(models.Notices.id).filter(models.Notices.id.in_(ids))
+    }
+    existing.update(
+        id
+        for (id,) in db.query(models.NoticesArchive.id).filter(
+            models.NoticesArchive.id.in_(ids)
+        )
+    )
+    return existing
+
+
 def get_notice_by_id(db: Session, notice_id: int):
     return (
         db.query(models.Notices).filter(models.Notices.id == notice_id).first()
@@ -52,9 +138,10 @@ def update_last_notice(db: Session, user_id: str, last_notice_id: int):
     return db_user
 
 
-def get_notices_with_date(db: Session, date: str):
+def get_notices_with_date(db: Session, date: date):
+    """카드에 필요한 다섯 열만 읽는다. (covering index 로 범위 조회 + 정렬)"""
     notices = (
-        db.query(models.Notices)
+        db.query(*NOTICE_CARD_COLUMNS)
         .filter(models.Notices.date == date)
         .order_by(models.Notices.id.desc())
         .all()
@@ -62,12 +149,57 @@ def get_notices_with_date(db: Session, date: str):
     return notices  # read notices by descending order
 
 
-def delete_old_notice(db: Session, date: str):
+def delete_old_notice(db: Session, date: date):
     delete = models.Notices.__table__.delete().where(models.Notices.date == date)
     db.execute(delete)
     db.commit()
 
 
+def archive_notices_before(db: Session, cutoff: date, limit: int = 500) -> int:
+    """date < cutoff 인 공지를 limit 개까지 archive 테이블로 옮긴다. (한 트랜잭션)
+
+    Returns:
+        옮긴 공지 수 (0 이면 더 옮길 것이 없다)
+    """
+    notices = models.Notices.__table__
+    ids = [
+        id
+        for (id,) in db.execute(
+            select(notices.c.id)
+            .where(notices.c.date < cutoff)
+            .order_by(notices.c.date, notices.c.id)  # (date, id) index
+            .limit(limit)
+        )
+    ]
+    if not ids:
+        return 0
+
+    columns = ["id", "title", "category", "date", "link", "writer"]
+    db.execute(
+        insert(models.NoticesArchive)
+        .from_select(
+            columns + ["archived_at"],
+            select(
+                *[notices.c[name] for name in columns], literal(datetime.now())
+            ).where(notices.c.id.in_(ids)),
+        )
+        .prefix_with("IGNORE", dialect="mysql")
+        .prefix_with("OR IGNORE", dialect="sqlite")
+    )
+    db.execute(delete(notices).where(notices.c.id.in_(ids)))
+    db.commit()
+    return len(ids)
+
+
+def get_checkpoint(db: Session, name: str):
+    """없으면 offset 0 으로 만든다. (commit 은 부르는 쪽에서)"""
+    checkpoint = db.get(models.CrawlCheckpoint, name)
+    if checkpoint is None:
+        checkpoint = models.CrawlCheckpoint(name=name, offset=0, complete=False)
+        db.add(checkpoint)
+    return checkpoint
+
+
 def get_all_sched(db: Session):
     scheds = db.query(models.Schedules).all()
     return scheds
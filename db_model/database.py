@@ -1,13 +1,164 @@
 import os
+import threading
+import time
 
-from sqlalchemy import create_engine
+from sqlalchemy import create_engine, event
+from sqlalchemy.engine import make_url
+from sqlalchemy.exc import TimeoutError as PoolTimeoutError
+from sqlalchemy.ext.asyncio import async_sessionmaker, create_async_engine
 from sqlalchemy.ext.declarative import declarative_base
 from sqlalchemy.orm import sessionmaker
-from sqlalchemy.pool import NullPool
+from sqlalchemy.pool import AsyncAdaptedQueuePool, QueuePool
 
 SQLALCHEMY_DATABASE_URL = os.environ["KAKAO_DB"]
+# async 드라이버 URL, 없으면 KAKAO_DB 의 드라이버만 aiomysql 로 바꾼다.
+SQLALCHEMY_ASYNC_DATABASE_URL = os.environ.get(
+    "KAKAO_ASYNC_DB",
+    str(make_url(SQLALCHEMY_DATABASE_URL).set(drivername="mysql+aiomysql")),
+)
 
-engine = create_engine(SQLALCHEMY_DATABASE_URL, pool_recycle=3600, poolclass=NullPool)
+# 워커 프로세스마다의 풀 크기 (RDS max_connections / 워커 수 를 넘지 않게)
+POOL_SIZE = int(os.environ.get("KAKAO_DB_POOL_SIZE", 5))
+POOL_OVERFLOW = int(os.environ.get("KAKAO_DB_MAX_OVERFLOW", 5))
+POOL_TIMEOUT = float(os.environ.get("KAKAO_DB_POOL_TIMEOUT", 3.0))  # checkout 대기
+POOL_RECYCLE = int(
+    os.environ.get("KAKAO_DB_POOL_RECYCLE", 1800)
+)  # RDS idle timeout 보다 짧게
+CONNECT_TIMEOUT = int(os.environ.get("KAKAO_DB_CONNECT_TIMEOUT", 3))
+
+
+class PoolMetrics:
+    """checkout 대기 시간 / 풀 고갈 / 끊긴 연결 수"""
+
+    __slots__ = (
+        "_lock",
+        "checkouts",
+        "wait_total",
+        "wait_max",
+        "exhausted",
+        "invalidated",
+    )
+
+    def __init__(self):
+        self._lock = threading.Lock()
+        self.checkouts = 0
+        self.wait_total = 0.0
+        self.wait_max = 0.0
+        self.exhausted = 0
+        self.invalidated = 0
+
+    def record_wait(self, seconds):
+        with self._lock:
+            self.checkouts += 1
+            self.wait_total += seconds
+            if seconds > self.wait_max:
+                self.wait_max = seconds
+
+    def record_exhausted(self):
+        with self._lock:
+            self.exhausted += 1
+
+    def record_invalidated(self):
+        with self._lock:
+            self.invalidated += 1
+
+    def snapshot(self):
+        with self._lock:
+            return {
+                "checkouts": self.checkouts,
+                "wait_avg_ms": (
+                    1000 * self.wait_total / self.checkouts if self.checkouts else 0.0
+                ),
+                "wait_max_ms": 1000 * self.wait_max,
+                "exhausted": self.exhausted,
+                "invalidated": self.invalidated,
+            }
+
+
+class _MeteredPool:
+    """QueuePool 에서 연결을 얻기까지 걸린 시간과 timeout 을 센다."""
+
+    metrics = None
+
+    def _do_get(self):
+        start = time.perf_counter()
+        try:
+            return super()._do_get()
+        except PoolTimeoutError:
+            self.metrics.record_exhausted()
+            raise
+        finally:
+            self.metrics.record_wait(time.perf_counter() - start)
+
+
+class MeteredQueuePool(_MeteredPool, QueuePool):
+    metrics = PoolMetrics()
+
+
+class MeteredAsyncQueuePool(_MeteredPool, AsyncAdaptedQueuePool):
+    metrics = PoolMetrics()
+
+
+def _pool_options(url, poolclass):
+    options = dict(
+        poolclass=poolclass,
+        pool_size=POOL_SIZE,
+        max_overflow=POOL_OVERFLOW,
+        pool_timeout=POOL_TIMEOUT,
+        pool_recycle=POOL_RECYCLE,
+        pool_pre_ping=True,  # failover 뒤 죽은 연결은 checkout 할 때 걸러진다
+    )
+    if make_url(url).get_backend_name() == "mysql":
+        options["connect_args"] = {"connect_timeout": CONNECT_TIMEOUT}
+    return options
+
+
+def _watch(engine, metrics):
+    @event.listens_for(engine.pool, "invalidate")
+    def _invalidated(dbapi_connection, connection_record, exception):
+        metrics.record_invalidated()
+
+
+engine = create_engine(
+    SQLALCHEMY_DATABASE_URL, **_pool_options(SQLALCHEMY_DATABASE_URL, MeteredQueuePool)
+)
+_watch(engine, MeteredQueuePool.metrics)
 SessionLocal = sessionmaker(autocommit=False, autoflush=False, bind=engine)
 
+try:
+    async_engine = create_async_engine(
+        SQLALCHEMY_ASYNC_DATABASE_URL,
+        **_pool_options(SQLALCHEMY_ASYNC_DATABASE_URL, MeteredAsyncQueuePool),
+    )
+    _watch(async_engine.sync_engine, MeteredAsyncQueuePool.metrics)
+    AsyncSessionLocal = async_sessionmaker(
+        bind=async_engine, autoflush=False, expire_on_commit=False
+    )
+except ImportError:  # async 드라이버 없음 (크롤러는 sync 만 쓴다)
+    async_engine = AsyncSessionLocal = None
+
+
+def _after_fork():
+    """fork 된 워커는 부모의 연결을 닫지 않고 버린 뒤 자기 풀을 새로 만든다."""
+    engine.dispose(close=False)
+    if async_engine is not None:
+        async_engine.sync_engine.dispose(close=False)
+
+
+if hasattr(os, "register_at_fork"):
+    os.register_at_fork(after_in_child=_after_fork)
+
+
+def pool_stats():
+    stats = {
+        "sync": dict(MeteredQueuePool.metrics.snapshot(), status=engine.pool.status())
+    }
+    if async_engine is not None:
+        stats["async"] = dict(
+            MeteredAsyncQueuePool.metrics.snapshot(),
+            status=async_engine.sync_engine.pool.status(),
+        )
+    return stats
+
+
 Base = declarative_base()
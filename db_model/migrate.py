@@ -0,0 +1,181 @@
+"""스키마 변경
+
+create_all() 은 이미 있는 테이블을 바꾸지 않으므로, 운영 DB 에 필요한 변경을
+순서대로 적용하고 schema_version 테이블에 번호를 남긴다.
+각 단계는 이미 적용된 상태에서 다시 돌려도 되게 만든다. (워커 여러 개가 동시에 시작)
+
+Usage
+-----
+    db_model.models.Base.metadata.create_all(bind=engine)
+    db_model.migrate.upgrade(engine)
+"""
+
+import re
+from datetime import date, datetime
+
+from sqlalchemy import inspect, select, text
+from sqlalchemy.sql import sqltypes
+
+from . import models
+
+CARD_INDEX = "ix_ajou_notices_card"
+
+
+# notice_scan.to_day 와 같은 규칙 ("21.03.01", "2021.03.01", "2021-03-01", 두 자리 연도는 2000 년대)
+_DAY = re.compile(r"[ \t\n\r\f]*(\d{1,4})[./-](\d{1,2})[./-](\d{1,2})[ \t\n\r\f]*")
+
+
+def _iso_day(text):
+    """홈페이지 날짜 문자열 -> "2021-03-01", 모르는 형식이면 None"""
+    match = _DAY.fullmatch(text)
+    if match is None:
+        return None
+    year, month, day = (int(g) for g in match.groups())
+    if len(match.group(1)) <= 2:
+        year += 2000
+    try:
+        return date(year, month, day).isoformat()
+    except ValueError:
+        return None
+
+
+def _notice_date(conn):
+    """ajou_notices.date: "21.03.01" 문자열 -> DATE + index"""
+    notices = models.Notices.__table__
+    column = next(
+        c for c in inspect(conn).get_columns(notices.name) if c["name"] == "date"
+    )
+
+    if not isinstance(column["type"], sqltypes.Date):
+        # SQL 의 LIKE/STR_TO_DATE 로는 형식을 다 못 맞추므로 한 줄씩 바꾼다. (한 번만 돈다)
+        changed, unknown = [], []
+        for id, text_date in conn.execute(
+            text("SELECT id, date FROM ajou_notices WHERE date IS NOT NULL")
+        ):
+            iso = _iso_day(text_date)
+            if iso is None:
+                unknown.append((id, text_date))
+            elif iso != text_date:
+                changed.append({"id": id, "date": iso})
+        if changed:
+            conn.execute(
+                text("UPDATE ajou_notices SET date = :date WHERE id = :id"), changed
+            )
+        if unknown:
+            conn.execute(
+                text("UPDATE ajou_notices SET date = NULL WHERE id = :id"),
+                [{"id": id} for id, _ in unknown],
+            )
+            # 날짜로 못 바꾼 값은 버리기 전에 남겨 둔다
+            print(
+                f"Migration: {len(unknown)} notices have an unknown date, set to NULL:"
+            )
+            for id, text_date in unknown:
+                print(f"    {id}: {text_date!r}")
+        if (
+            conn.dialect.name == "mysql"
+        ):  # sqlite: Date 는 "2021-03-01" 문자열로 저장된다
+            conn.execute(text("ALTER TABLE ajou_notices MODIFY date DATE NULL"))
+
+    if not {"ix_ajou_notices_date", "ix_ajou_notices_date_id", CARD_INDEX} & _indexes(
+        conn
+    ):
+        conn.execute(text("CREATE INDEX ix_ajou_notices_date ON ajou_notices (date)"))
+
+
+def _notice_date_id(conn):
+    """(date, id) 복합 index 로 바꾼다. date 하나짜리 index 는 이것으로 대신한다."""
+    indexes = _indexes(conn)
+    if not {"ix_ajou_notices_date_id", CARD_INDEX} & indexes:
+        conn.execute(
+            text("CREATE INDEX ix_ajou_notices_date_id ON ajou_notices (date, id)")
+        )
+    if "ix_ajou_notices_date" in indexes:
+        on = " ON ajou_notices" if conn.dialect.name == "mysql" else ""
+        conn.execute(text(f"DROP INDEX ix_ajou_notices_date{on}"))
+
+
+def _notice_card(conn):
+    """get_notices_with_date 의 다섯 열을 덮는 index 로 바꾼다. (clustered index 를 안 본다)
+
+    (date, id) 로 시작하므로 retention 의 (date, id) 순서 조회도 이것을 쓴다.
+    """
+    indexes = _indexes(conn)
+    if CARD_INDEX not in indexes:
+        conn.execute(
+            text(
+                f"CREATE INDEX {CARD_INDEX} ON ajou_notices (date, id, title, link, writer)"
+            )
+        )
+    for old in ("ix_ajou_notices_date_id", "ix_ajou_notices_date"):
+        if old in indexes:
+            on = " ON ajou_notices" if conn.dialect.name == "mysql" else ""
+            conn.execute(text(f"DROP INDEX {old}{on}"))
+
+
+def _checkpoint_newest(conn):
+    """ajou_crawl_checkpoint.newest_id (NULL 이면 backfill 이 예전처럼 저장된 id 에서 멈춘다)"""
+    columns = inspect(conn).get_columns(models.CrawlCheckpoint.__tablename__)
+    if "newest_id" not in {column["name"] for column in columns}:
+        conn.execute(
+            text("ALTER TABLE ajou_crawl_checkpoint ADD COLUMN newest_id INTEGER")
+        )
+
+
+# Index(...) 객체는 만들기만 해도 Table 에 붙으므로 (create_all 대상이 된다) DDL 은 직접 쓴다.
+def _indexes(conn):
+    return {index["name"] for index in inspect(conn).get_indexes("ajou_notices")}
+
+
+MIGRATIONS = [
+    (1, "ajou_notices.date DATE + index", _notice_date),
+    (2, "ajou_notices (date, id) index", _notice_date_id),
+    (3, "ajou_notices covering card index", _notice_card),
+    (4, "ajou_crawl_checkpoint.newest_id", _checkpoint_newest),
+]
+
+
+def _applied(engine, version):
+    table = models.SchemaVersion.__table__
+    with engine.connect() as conn:
+        return (
+            conn.execute(
+                select(table.c.version).where(table.c.version == version)
+            ).first()
+            is not None
+        )
+
+
+def upgrade(engine):
+    """적용 안 된 단계를 순서대로 돌린다. 적용한 단계 수를 돌려준다."""
+    table = models.SchemaVersion.__table__
+    with engine.connect() as conn:
+        done = set(conn.execute(select(table.c.version)).scalars())
+
+    applied = 0
+    for version, description, step in MIGRATIONS:
+        if version in done:
+            continue
+        try:
+            with engine.begin() as conn:
+                step(conn)
+                conn.execute(
+                    table.insert()
+                    .values(
+                        version=version,
+                        description=description,
+                        applied_at=datetime.now(),
+                    )
+                    .prefix_with("IGNORE", dialect="mysql")
+                    .prefix_with("OR IGNORE", dialect="sqlite")
+                )
+        except Exception as e:
+            if _applied(engine, version):  # 다른 워커가 같은 단계를 먼저 끝냈다
+                print(f"Migration {version} ({description}) done by another worker")
+                continue
+            # 반쯤 바뀐 스키마로 뜨지 않도록 시작을 멈춘다
+            print(f"Migration {version} ({description}) failed: {e}")
+            raise
+        print(f"Migrated schema to {version}: {description}")
+        applied += 1
+    return applied
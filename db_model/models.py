@@ -1,19 +1,39 @@
-from sqlalchemy import Column, Integer, String
+from sqlalchemy import Boolean, Column, Date, DateTime, Index, Integer, String
 
 from .database import Base
 
 
 class Notices(Base):
     __tablename__ = "ajou_notices"
+    # 날짜로 거르고 id desc 로 정렬, 카드 열까지 index 에서 읽는다 (get_notices_with_date)
+    # utf8mb4 로도 약 920 byte 라 InnoDB 한도 (3072) 안이고 prefix 없이 전부 덮는다.
+    __table_args__ = (
+        Index("ix_ajou_notices_card", "date", "id", "title", "link", "writer"),
+    )
 
     id = Column(Integer, primary_key=True, unique=True)
     title = Column(String(100))
     category = Column(String(5))
-    date = Column(String(30))
+    date = Column(Date)
     link = Column(String(101))
     writer = Column(String(25))
 
 
+class NoticesArchive(Base):
+    """retention 이 ajou_notices 에서 옮긴 오래된 공지 (MySQL 은 압축 row)"""
+
+    __tablename__ = "ajou_notices_archive"
+    __table_args__ = {"mysql_row_format": "COMPRESSED"}
+
+    id = Column(Integer, primary_key=True, autoincrement=False)
+    title = Column(String(100))
+    category = Column(String(5))
+    date = Column(Date)
+    link = Column(String(101))
+    writer = Column(String(25))
+    archived_at = Column(DateTime)
+
+
 class Users(Base):
     __tablename__ = "users"
 
@@ -28,3 +48,27 @@ class Schedules(Base):
     content = Column(String(50))
     start_date = Column(String(12))
     end_date = Column(String(12))
+
+
+class CrawlCheckpoint(Base):
+    """backfill 이 어디까지 읽었는지 (article.offset)"""
+
+    __tablename__ = "ajou_crawl_checkpoint"
+
+    name = Column(String(32), primary_key=True)
+    offset = Column(Integer, nullable=False, default=0)
+    complete = Column(
+        Boolean, nullable=False, default=False
+    )  # 목록 끝까지 한 번 읽었다
+    newest_id = Column(Integer)  # 여기까지 빈틈 없이 읽었다 (backfill 의 incremental)
+    updated_at = Column(DateTime)
+
+
+class SchemaVersion(Base):
+    """migrate.py 가 적용한 스키마 변경 번호"""
+
+    __tablename__ = "schema_version"
+
+    version = Column(Integer, primary_key=True, autoincrement=False)
+    description = Column(String(100))
+    applied_at = Column(DateTime)
@@ -1,10 +1,12 @@
+from datetime import date
+
 from pydantic import BaseModel
 
 
 class NoticeInfo(BaseModel):
     id: int
     title: str
-    date: str
+    date: date
     link: str
     writer: str
 
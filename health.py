@@ -0,0 +1,120 @@
+"""업스트림(아주대 홈페이지) 상태
+
+실제 fetch 결과로 살아있는지를 기록하고, 요청이 뜸할 때는 백그라운드 probe 가
+가볍게 확인한다. is_alive() 는 I/O 없이 O(1).
+down 이어도 retry 초마다 요청 하나는 통과시킨다. (probe 가 없는 pre-fork 워커도
+그 fetch 결과로 다시 up 이 된다)
+
+환경 변수
+    AJOU_HEALTH_FAILURES  연속 실패 몇 번이면 down 으로 볼지 (default 2)
+    AJOU_HEALTH_INTERVAL  probe 주기(초) (default 15)
+"""
+
+import os
+import threading
+import time
+
+FAILURE_THRESHOLD = int(os.environ.get("AJOU_HEALTH_FAILURES", 2))
+PROBE_INTERVAL = float(os.environ.get("AJOU_HEALTH_INTERVAL", 15.0))
+
+
+class UpstreamHealth:
+    """
+    Methods
+    -------
+    record_success()
+    record_failure(reason)
+    is_alive() -> bool
+    start_probe(probe, interval)
+    """
+
+    __slots__ = (
+        "host",
+        "threshold",
+        "retry",
+        "alive",
+        "failures",
+        "last_success",
+        "last_failure",
+        "last_reason",
+        "last_checked",
+        "_probe",
+    )
+
+    def __init__(self, host, threshold=FAILURE_THRESHOLD, retry=PROBE_INTERVAL):
+        self.host = host
+        self.threshold = threshold
+        self.retry = retry
+        self.alive = True  # 모르면 살아있다고 본다
+        self.failures = 0
+        self.last_success = 0.0
+        self.last_failure = 0.0
+        self.last_reason = None
+        self.last_checked = 0.0
+        self._probe = None
+
+    # 경합이 나도 카운터가 하나 틀리는 정도라 lock 없이 둔다. (hot path)
+    def record_success(self):
+        now = time.monotonic()
+        self.failures = 0
+        self.last_success = self.last_checked = now
+        self.alive = True
+
+    def record_failure(self, reason=None):
+        now = time.monotonic()
+        self.failures += 1
+        self.last_failure = self.last_checked = now
+        self.last_reason = reason
+        if self.failures >= self.threshold:
+            self.alive = False
+
+    def is_alive(self):
+        if self.alive:
+            return True
+        now = time.monotonic()
+        if now - self.last_checked >= self.retry:
+            self.last_checked = now  # 이번 요청만 실제로 불러 본다
+            return True
+        return False
+
+    def start_probe(self, probe, interval=PROBE_INTERVAL):
+        """
+        probe() 를 interval 마다 부른다. (예외 = 실패)
+        최근 interval 안에 실제 fetch 결과가 있었으면 건너뛴다.
+        """
+        if self._probe is not None:
+            return self._probe
+
+        def loop():
+            while True:
+                time.sleep(interval)
+                if time.monotonic() - self.last_checked < interval:
+                    continue  # passive 결과로 충분
+                try:
+                    probe()
+                except Exception:
+                    pass  # probe 가 부르는 fetch 가 이미 기록했다
+
+        self._probe = threading.Thread(
+            target=loop, name=f"health-probe-{self.host}", daemon=True
+        )
+        self._probe.start()
+        return self._probe
+
+    def __repr__(self) -> str:
+        state = "up" if self.alive else "down"
+        return f"<UpstreamHealth {self.host} {state} failures={self.failures}>"
+
+
+_states = {}
+_states_lock = threading.Lock()
+
+
+def upstream(host):
+    state = _states.get(host)
+    if state is None:
+        with _states_lock:
+            state = _states.get(host)
+            if state is None:
+                state = _states[host] = UpstreamHealth(host)
+    return state
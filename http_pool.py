@@ -0,0 +1,430 @@
+"""아주대 홈페이지용 keep-alive HTTPS 커넥션 풀
+
+urlopen 은 호출마다 TCP 연결 + TLS handshake 를 새로 하므로
+같은 호스트에 대한 HTTP/1.1 연결을 재사용한다.
+
+Usage
+-----
+    from http_pool import afetch, fetch
+
+    response = fetch("https://www.ajou.ac.kr/kr/ajou/notice.do", timeout=2.0)
+    response.status, response.body
+
+    response = await afetch(url, timeout=2.0)  # asyncio (httpx)
+
+환경 변수
+    AJOU_POOL_SIZE  호스트당 최대 연결 수 (default 8, get_pool(size=) 로 늘릴 수 있다)
+    AJOU_POOL_IDLE  idle 연결을 닫기까지의 시간(초) (default 60)
+"""
+
+import asyncio
+import http.client
+import os
+import socket
+import ssl
+import threading
+import time
+from urllib.error import HTTPError, URLError
+from urllib.parse import urljoin, urlsplit
+
+import health
+
+try:
+    import httpx
+except ImportError:  # 크롤러처럼 async 경로를 안 쓰면 없어도 된다
+    httpx = None
+
+POOL_SIZE = int(os.environ.get("AJOU_POOL_SIZE", 8))
+POOL_IDLE = float(os.environ.get("AJOU_POOL_IDLE", 60.0))
+MAX_REDIRECTS = 3
+
+
+class Response:
+    __slots__ = ("url", "status", "headers", "body")
+
+    def __init__(self, url, status, headers, body):
+        self.url = url
+        self.status = status
+        self.headers = headers
+        self.body = body
+
+    def __repr__(self) -> str:
+        return f"<Response [{self.status}] {self.url} ({len(self.body)} bytes)>"
+
+
+class _Call:
+    __slots__ = ("done", "value", "error")
+
+    def __init__(self):
+        self.done = threading.Event()
+        self.value = None
+        self.error = None
+
+
+class SingleFlight:
+    """
+    같은 key 로 동시에 들어온 호출은 하나만 실행하고 결과(또는 예외)를 나눠 갖는다.
+
+    Usage
+    -----
+        flights = SingleFlight()
+        notices = flights.do(url, lambda: parse(fetch(url)))
+    """
+
+    __slots__ = ("_calls", "_lock", "calls", "shared")
+
+    def __init__(self):
+        self._calls = {}
+        self._lock = threading.Lock()
+        self.calls = 0  # 실제로 실행된 횟수
+        self.shared = 0  # 다른 호출 결과를 기다려서 받은 횟수
+
+    def do(self, key, fn):
+        with self._lock:
+            call = self._calls.get(key)
+            owner = call is None
+            if owner:
+                call = self._calls[key] = _Call()
+                self.calls += 1
+            else:
+                self.shared += 1
+
+        if owner:
+            try:
+                call.value = fn()
+            except BaseException as e:
+                call.error = e
+            finally:
+                with self._lock:
+                    del self._calls[key]
+                call.done.set()
+        else:
+            call.done.wait()
+
+        if call.error is not None:
+            raise call.error
+        return call.value
+
+    def pending(self, key):
+        return key in self._calls
+
+
+class AsyncSingleFlight:
+    """SingleFlight 의 asyncio 버전. fn() 은 awaitable 을 돌려준다."""
+
+    __slots__ = ("_calls", "calls", "shared")
+
+    def __init__(self):
+        self._calls = {}
+        self.calls = 0
+        self.shared = 0
+
+    async def do(self, key, fn):
+        task = self._calls.get(key)
+        if task is None:
+            task = asyncio.ensure_future(fn())
+            self._calls[key] = task
+            task.add_done_callback(lambda _: self._calls.pop(key, None))
+            self.calls += 1
+        else:
+            self.shared += 1
+        # 기다리던 요청 하나가 취소돼도 나머지를 위해 fetch 는 계속한다.
+        return await asyncio.shield(task)
+
+    def pending(self, key):
+        return key in self._calls
+
+
+class PooledConnection:
+    """연결 하나 + 통계"""
+
+    __slots__ = ("conn", "requests", "created", "last_used")
+
+    def __init__(self, conn):
+        self.conn = conn
+        self.requests = 0
+        self.created = self.last_used = time.monotonic()
+
+    def close(self):
+        try:
+            self.conn.close()
+        except Exception:
+            pass
+
+
+class ConnectionPool:
+    """
+    한 호스트에 대한 thread-safe keep-alive 연결 풀
+
+    Methods
+    -------
+    request(path, timeout, headers) -> Response
+    reserve(size)
+    reap() -> int
+    stats() -> dict
+    """
+
+    __slots__ = (
+        "host",
+        "port",
+        "size",
+        "idle_timeout",
+        "_context",
+        "_idle",
+        "_in_use",
+        "_cond",
+        "_opened",
+        "_closed",
+        "_requests",
+    )
+
+    def __init__(self, host, port=443, size=POOL_SIZE, idle_timeout=POOL_IDLE):
+        self.host = host
+        self.port = port
+        self.size = size
+        self.idle_timeout = idle_timeout
+        self._context = ssl._create_unverified_context()
+        self._idle = []  # LIFO, 최근에 쓴 연결부터 재사용
+        self._in_use = 0
+        self._cond = threading.Condition(threading.Lock())
+        self._opened = 0
+        self._closed = 0
+        self._requests = 0
+
+    def _connect(self, timeout):
+        conn = http.client.HTTPSConnection(
+            self.host, self.port, timeout=timeout, context=self._context
+        )
+        with self._cond:
+            self._opened += 1
+        return PooledConnection(conn)
+
+    def _acquire(self, timeout):
+        deadline = time.monotonic() + timeout
+        with self._cond:
+            while True:
+                self._reap_locked()
+                if self._idle:
+                    self._in_use += 1
+                    return self._idle.pop()
+                if self._in_use < self.size:
+                    self._in_use += 1
+                    break
+                remaining = deadline - time.monotonic()
+                if remaining <= 0:
+                    raise TimeoutError(f"connection pool for {self.host} exhausted")
+                self._cond.wait(remaining)
+
+        try:
+            return self._connect(timeout)
+        except BaseException:
+            with self._cond:
+                self._in_use -= 1
+                self._cond.notify()
+            raise
+
+    def reserve(self, size):
+        """최대 연결 수를 size 이상으로 늘린다. (줄이지는 않는다)"""
+        with self._cond:
+            if size > self.size:
+                self.size = size
+                self._cond.notify_all()
+
+    def _release(self, pooled, reusable):
+        with self._cond:
+            self._in_use -= 1
+            if reusable:
+                pooled.last_used = time.monotonic()
+                self._idle.append(pooled)
+            else:
+                self._closed += 1
+            self._cond.notify()
+        if not reusable:
+            pooled.close()
+
+    def _reap_locked(self):
+        """idle_timeout 을 넘긴 연결을 닫는다. (lock 보유 상태)"""
+        if not self._idle:
+            return 0
+        limit = time.monotonic() - self.idle_timeout
+        alive = [p for p in self._idle if p.last_used >= limit]
+        reaped = len(self._idle) - len(alive)
+        if reaped:
+            for pooled in self._idle:
+                if pooled.last_used < limit:
+                    pooled.close()
+            self._idle = alive
+            self._closed += reaped
+        return reaped
+
+    def reap(self):
+        with self._cond:
+            return self._reap_locked()
+
+    def request(self, path, timeout=2.0, headers=None):
+        """GET path. 재사용한 연결이 서버쪽에서 끊겼으면 한 번만 새 연결로 다시 보낸다."""
+        send_headers = {"Connection": "keep-alive"}
+        if headers:
+            send_headers.update(headers)
+
+        for attempt in range(2):
+            pooled = self._acquire(timeout)
+            reused = pooled.requests > 0
+            try:
+                pooled.conn.timeout = timeout
+                if pooled.conn.sock is not None:
+                    pooled.conn.sock.settimeout(timeout)
+                pooled.conn.request("GET", path, headers=send_headers)
+                result = pooled.conn.getresponse()
+                body = result.read()
+            except (
+                http.client.RemoteDisconnected,
+                http.client.BadStatusLine,
+                BrokenPipeError,
+                ConnectionResetError,
+            ):
+                self._release(pooled, False)
+                if reused and attempt == 0:
+                    continue  # stale keep-alive
+                raise
+            except BaseException:
+                self._release(pooled, False)
+                raise
+
+            pooled.requests += 1
+            with self._cond:
+                self._requests += 1
+            self._release(pooled, not result.will_close)
+            return result.status, result.headers, body
+
+    def close(self):
+        with self._cond:
+            idle, self._idle = self._idle, []
+            self._closed += len(idle)
+        for pooled in idle:
+            pooled.close()
+
+    def stats(self):
+        with self._cond:
+            return {
+                "host": self.host,
+                "size": self.size,
+                "idle": len(self._idle),
+                "in_use": self._in_use,
+                "opened": self._opened,
+                "closed": self._closed,
+                "requests": self._requests,
+                "per_connection": [p.requests for p in self._idle],
+            }
+
+
+_pools = {}
+_pools_lock = threading.Lock()
+
+
+def get_pool(host, port=443, size=None):
+    """size 를 주면 그만큼은 동시에 연결할 수 있게 한다. (crawler 의 per_host)"""
+    key = (host, port)
+    pool = _pools.get(key)
+    if pool is None:
+        with _pools_lock:
+            pool = _pools.get(key)
+            if pool is None:
+                pool = _pools[key] = ConnectionPool(host, port)
+    if size is not None:
+        pool.reserve(size)
+    return pool
+
+
+def fetch(url, timeout=2.0, headers=None):
+    """
+    url 을 GET 해서 Response 로 돌려준다. urlopen 과 같은 예외를 던진다.
+        HTTPError     4xx/5xx
+        URLError      연결 실패
+        TimeoutError  timeout
+    결과는 health.upstream(host) 에 기록된다.
+    """
+    for _ in range(MAX_REDIRECTS + 1):
+        parts = urlsplit(url)
+        path = parts.path or "/"
+        if parts.query:
+            path += "?" + parts.query
+        pool = get_pool(parts.hostname, parts.port or 443)
+        state = health.upstream(parts.hostname)
+
+        try:
+            status, resp_headers, body = pool.request(path, timeout, headers)
+        except (TimeoutError, socket.timeout):
+            state.record_failure("timeout")
+            raise
+        except (OSError, http.client.HTTPException) as e:
+            state.record_failure(repr(e))
+            raise URLError(e) from e
+
+        if status in (301, 302, 303, 307, 308) and "Location" in resp_headers:
+            state.record_success()
+            url = urljoin(url, resp_headers["Location"])
+            continue
+        _check_status(url, status, resp_headers, state)
+        return Response(url, status, resp_headers, body)
+
+    raise URLError(f"too many redirects: {url}")
+
+
+def _check_status(url, status, resp_headers, state):
+    if status >= 500:
+        state.record_failure(f"HTTP {status}")
+    else:
+        state.record_success()
+    if status >= 400:
+        raise HTTPError(
+            url, status, http.client.responses.get(status, ""), resp_headers, None
+        )
+
+
+_async_client = None
+
+
+def get_async_client():
+    """이벤트 루프 안에서 처음 부를 때 만든다. (워커 프로세스마다 하나)"""
+    global _async_client
+    if _async_client is None:
+        _async_client = httpx.AsyncClient(
+            verify=False,  # ssl._create_unverified_context() 와 같다
+            follow_redirects=True,
+            max_redirects=MAX_REDIRECTS,
+            limits=httpx.Limits(
+                max_connections=POOL_SIZE,
+                max_keepalive_connections=POOL_SIZE,
+                keepalive_expiry=POOL_IDLE,
+            ),
+        )
+    return _async_client
+
+
+async def afetch(url, timeout=2.0, headers=None):
+    """fetch() 의 non-blocking 버전. 예외와 health 기록도 같다."""
+    state = health.upstream(urlsplit(url).hostname)
+    try:
+        result = await get_async_client().get(url, timeout=timeout, headers=headers)
+    except httpx.TimeoutException as e:
+        state.record_failure("timeout")
+        raise TimeoutError(str(e)) from e
+    except httpx.HTTPError as e:
+        state.record_failure(repr(e))
+        raise URLError(e) from e
+
+    _check_status(str(result.url), result.status_code, result.headers, state)
+    return Response(str(result.url), result.status_code, result.headers, result.content)
+
+
+async def aclose():
+    global _async_client
+    if _async_client is not None:
+        await _async_client.aclose()
+        _async_client = None
+
+
+def stats():
+    with _pools_lock:
+        return [pool.stats() for pool in _pools.values()]
@@ -1,3 +1,6 @@
+from json.encoder import encode_basestring
+
+
 class Kjson:
     __slots__ = ()
 
@@ -50,3 +53,163 @@ class Kjson:
         if quickReplies is not None:
             data["template"]["quickReplies"] = quickReplies
         return data
+
+
+def _s(value):
+    """str -> JSON 문자열 bytes (따옴표 포함), json.dumps(ensure_ascii=False) 와 같다."""
+    return encode_basestring(value).encode("utf-8")
+
+
+# 카카오 ListCard 글자 수 제한
+HEADER_LIMIT = 15
+TITLE_LIMIT = 35
+DESCRIPTION_LIMIT = 16
+
+try:
+    from ajou_native import build_card as _build_card
+    from ajou_native import json_field as _field
+except ImportError:  # not built
+    _build_card = None
+
+    def _field(text, limit=0, strip=None):
+        """ "[strip]" 제거 + limit 자 넘으면 limit-2 자 + ".." + JSON escape"""
+        if strip is not None:
+            duplicate = "[" + strip + "]"
+            if duplicate in text:  # writer: [writer] title
+                text = text.replace(duplicate, "").strip()  # -> writer: title
+        if limit > 2 and len(text) > limit:
+            text = text[: limit - 2] + ".."
+        return _s(text)
+
+
+class Ktemplate:
+    """
+    Kjson 과 같은 응답을 dict 없이 bytes 로 바로 만든다.
+
+    각 응답 타입의 고정된 뼈대는 import 할 때 한 번만 인코딩해 두고,
+    요청마다 바뀌는 값만 escape 해서 끼워 넣는다.
+    items / buttons / quickReplies 는 이미 인코딩된 조각(bytes) 목록이다.
+
+    Usage
+    -----
+        items = [Ktemplate.buildCard(...), ...]
+        body = Ktemplate.buildListCard("오늘 공지", items, [Ktemplate.SHARE])
+        Response(content=body, media_type="application/json")
+    """
+
+    __slots__ = ()
+
+    _SIMPLE_TEXT = b'{"version":"2.0","template":{"outputs":[{"simpleText":{"text":'
+    _LIST_CARD = (
+        b'{"version":"2.0","template":{"outputs":[{"listCard":{"header":{"title":'
+    )
+    _CAROUSEL = b'{"version":"2.0","template":{"outputs":[{"carousel":{"type":"basicCard","items":['
+    _QUICK_REPLIES = b',"quickReplies":['
+    _END = b"}}"
+
+    SHARE = '{"label":"공유하기","action":"share"}'.encode("utf-8")
+
+    @staticmethod
+    def buildCard(postId, postTitle, postDate, postLink, postWriter, putDate=False):
+        """Kjson.buildCard 와 같은 리스트 카드 (bytes), 필드는 카카오 글자 수 제한에 맞춘다."""
+        if _build_card is not None:
+            return _build_card(postTitle, postDate, postLink, postWriter, putDate)
+
+        if putDate:
+            description = f"{postWriter} {postDate[len(postDate) -5:]}"
+        else:
+            description = postWriter
+
+        return b"".join(
+            (
+                b'{"title":',
+                _field(postTitle, TITLE_LIMIT, postWriter),
+                b',"description":',
+                _field(description, DESCRIPTION_LIMIT),
+                b',"link":{"web":',
+                _s(postLink),
+                b"}}",
+            )
+        )
+
+    @staticmethod
+    def buildEmptyCard(title, imageUrl):
+        return b"".join((b'{"title":', _s(title), b',"imageUrl":', _s(imageUrl), b"}"))
+
+    @staticmethod
+    def buildBasicCard(title, desc, imageUrl):
+        return b"".join(
+            (
+                b'{"title":',
+                _s(title),
+                b',"description":',
+                _s(desc),
+                b',"thumbnail":{"imageUrl":',
+                _s(imageUrl),
+                b"}}",
+            )
+        )
+
+    @staticmethod
+    def buildWebLinkButton(label, url):
+        return b"".join(
+            (
+                b'{"label":',
+                _s(label),
+                b',"action":"webLink","webLinkUrl":',
+                _s(url),
+                b"}",
+            )
+        )
+
+    @staticmethod
+    def buildQuickReply(label, messageText=None):
+        return b"".join(
+            (
+                b'{"messageText":',
+                _s(label if messageText is None else messageText),
+                b',"action":"message","label":',
+                _s(label),
+                b"}",
+            )
+        )
+
+    @staticmethod
+    def _quickReplies(quickReplies):
+        if quickReplies is None:
+            return b""
+        return Ktemplate._QUICK_REPLIES + b",".join(quickReplies) + b"]"
+
+    @staticmethod
+    def buildSimpleText(msg, quickReplies=None):
+        return b"".join(
+            (
+                Ktemplate._SIMPLE_TEXT,
+                _s(msg),  # max len = 1000
+                b"}}]",
+                Ktemplate._quickReplies(quickReplies),
+                Ktemplate._END,
+            )
+        )
+
+    @staticmethod
+    def buildListCard(title, items, buttons, quickReplies=None):
+        return b"".join(
+            (
+                Ktemplate._LIST_CARD,
+                _field(title, HEADER_LIMIT),
+                b'},"items":[',
+                b",".join(items),
+                b'],"buttons":[',
+                b",".join(buttons),
+                b"]}}]",
+                Ktemplate._quickReplies(quickReplies),
+                Ktemplate._END,
+            )
+        )
+
+    @staticmethod
+    def buildCarousel(items):
+        return b"".join(
+            (Ktemplate._CAROUSEL, b",".join(items), b"]}}]", Ktemplate._END)
+        )
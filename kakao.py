@@ -1,25 +1,38 @@
 import functools
-from datetime import datetime, timedelta
+from datetime import date, timedelta
 from random import choice
-from typing import Dict
 from urllib.parse import quote
 
 import uvicorn
 from fastapi import Depends, FastAPI
 from fastapi.middleware.cors import CORSMiddleware
 from fastapi.responses import JSONResponse
-from sqlalchemy.orm import Session
+from sqlalchemy.ext.asyncio import AsyncSession
 
-import db_model.crud
+import db_model.async_crud
 import db_model.database
+import db_model.migrate
 import db_model.models
 import db_model.schemas
-from json_model import Kjson
-from notice_model import Homepage
+import http_pool
+import prefork
+from categories import CATEGORIES
+from json_model import Ktemplate
+from native_server import NATIVE_HTTP, NativeFrontend
+from notice_model import Homepage, cardCache, noticeCache, readModel
+from raw_response import Prepared, RawResponse
+from read_model import LATEST
+from response_cache import ResponseCache
+from skill_request import SkillRequest, readSkill
+from user_registry import UserRegistry
 
 ADDRESS = "https://www.ajou.ac.kr/kr/ajou/notice.do"
 
 db_model.models.Base.metadata.create_all(bind=db_model.database.engine)
+db_model.migrate.upgrade(db_model.database.engine)
+userRegistry = UserRegistry()
+scheduleCache = ResponseCache()  # 학사일정, ttl 마다 다시 읽는다
+nativeFrontend = None  # KAKAO_NATIVE_HTTP=1 로 띄웠을 때
 application = FastAPI(
     title="Ajou notices server", description="for Kakao Chatbot", version="1.0.0"
 )
@@ -31,50 +44,77 @@ application.add_middleware(
     allow_credentials=True,
 )
 
+
+@application.on_event("startup")
+def startHealthProbe():
+    """checkConnection() 은 I/O 없이 상태만 읽으므로, 한가할 때는 probe 로 갱신"""
+    if not prefork.inWorker():  # pre-fork 면 publisher 만 probe 한다
+        Homepage.startHealthProbe()
+
+
+@application.on_event("startup")
+async def startIngest():
+    """오늘/마지막/카테고리 공지는 요청이 아니라 ingest 가 불러온다."""
+    if not prefork.sharesModel():  # pre-fork 워커는 publisher 의 snapshot 을 쓴다
+        await readModel.start()
+
+
+@application.on_event("startup")
+def loadUsers():
+    """이미 있는 유저는 요청마다 DB 를 보지 않도록 미리 올려둔다."""
+    print(f"Loaded {userRegistry.preload()} users")
+    userRegistry.start()
+
+
+@application.on_event("shutdown")
+async def closeClients():
+    userRegistry.flush()
+    readModel.stop()
+    await http_pool.aclose()
+    if db_model.database.async_engine is not None:
+        await db_model.database.async_engine.dispose()
+
+
 # Decorators
 def checkUserAvailability(func):
     @functools.wraps(func)
-    def __isUser(*args, **kwargs):
-        content, db = args
+    async def __isUser(*args, **kwargs):
+        # FastAPI 는 키워드 인자로 부른다.
+        skill = args[0] if args else kwargs["skill"]
 
-        if content is not None:
-            user_id = content["userRequest"]["user"]["id"]  # user Id
-            user = db_model.crud.get_user_by_user_id(db=db, user_id=user_id)
-            if user is None:
-                user = db_model.crud.create_user(db=db, user_id=user_id)
-        return func(*args, **kwargs)
+        if skill.userId is not None:
+            userRegistry.ensure(skill.userId)  # 새 유저는 write-behind 로 저장
+        return await func(*args, **kwargs)
 
     return __isUser
 
 
 # SQL START
 
+
 # Dependency
-def get_db():
-    db = db_model.database.SessionLocal()
-    try:
+async def get_db():
+    async with db_model.database.AsyncSessionLocal() as db:
         yield db
-    finally:
-        db.close()
 
 
-def checkLastNotice(db: Session, user_id: str):
-    user = db_model.crud.get_user_by_user_id(db=db, user_id=user_id)
+async def checkLastNotice(db: AsyncSession, user_id: str):
+    user = await db_model.async_crud.get_user_by_user_id(db=db, user_id=user_id)
     if user is None:
-        user = db_model.crud.create_user(db=db, user_id=user_id)
+        user = await db_model.async_crud.create_user(db=db, user_id=user_id)
     last_id = user.last_notice_id
     return last_id
 
 
-def getSchedule(db: Session):
-    return db_model.crud.get_all_sched(db=db)
+async def getSchedule(db: AsyncSession):
+    return await db_model.async_crud.get_all_sched(db=db)
 
 
-def updateLastNotice(db: Session, user_id: str, notice_id: int):
-    user = db_model.crud.get_user_by_user_id(db=db, user_id=user_id)
+async def updateLastNotice(db: AsyncSession, user_id: str, notice_id: int):
+    user = await db_model.async_crud.get_user_by_user_id(db=db, user_id=user_id)
     if user is None:
-        user = db_model.crud.create_user(db=db, user_id=user_id)
-    user = db_model.crud.update_last_notice(
+        user = await db_model.async_crud.create_user(db=db, user_id=user_id)
+    user = await db_model.async_crud.update_last_notice(
         db=db, user_id=user_id, last_notice_id=notice_id
     )
     return user
@@ -83,122 +123,138 @@ def updateLastNotice(db: Session, user_id: str, notice_id: int):
 # SQL END
 
 
-def makeTimeoutMessage():
-    """checkConnection() 결과 False, 아래 JSON 데이터를 return"""
-    return JSONResponse(
-        content=Kjson.buildSimpleText("아주대학교 홈페이지 서버 반응이 늦고 있네요. 잠시 후 다시 시도해보세요.")
-    )
-
-
-def makeCarouselCard(title, desc):
-    card_imgs = ["ajou_carousel", "ajou_carousel_1", "ajou_carousel_2"]
-    card = {
-        "title": title,
-        "description": desc,
-        "thumbnail": {
-            "imageUrl": f"https://raw.githubusercontent.com/Alfex4936/kakaoChatbot-Ajou/main/imgs/{choice(card_imgs)}.png"
-        },
-        #   "buttons": [  optional
-        #     {
-        #       "action": "message",
-        #       "label": "열어보기",
-        #       "messageText": "짜잔! 우리가 찾던 보물입니다"
-        #     },
-        #   ]
-    }
+def kakaoResponse(body):
+    """Ktemplate 으로 만든 bytes (또는 Prepared) 를 그대로 보낸다. (json.dumps X)"""
+    return RawResponse(body)
 
-    return card
 
+TIMEOUT_MESSAGE = Prepared(
+    Ktemplate.buildSimpleText(
+        "아주대학교 홈페이지 서버 반응이 늦고 있네요. 잠시 후 다시 시도해보세요."
+    )
+)
 
-def getTodayNotices(now):
-    """30개 정도의 공지 목록을 읽고, 날짜에 맞는 것만 return"""
-    noticesToday = []
-    append = noticesToday.append
 
-    length = 30
+def makeTimeoutMessage():
+    """checkConnection() 결과 False, 아래 JSON 데이터를 return"""
+    return kakaoResponse(TIMEOUT_MESSAGE)
 
-    notices, noticeLength = Homepage.parseNotices(length=length)  # Parse notices
 
-    for i in range(noticeLength):
-        if notices[i].date != now:
-            notices = notices[:i]
-            break  # don't have to check other notices
+def makeCarouselCard(title, desc):
+    card_imgs = ["ajou_carousel", "ajou_carousel_1", "ajou_carousel_2"]
+    #   "buttons": [  optional
+    #     {
+    #       "action": "message",
+    #       "label": "열어보기",
+    #       "messageText": "짜잔! 우리가 찾던 보물입니다"
+    #     },
+    #   ]
+    return Ktemplate.buildBasicCard(
+        title,
+        desc,
+        f"https://raw.githubusercontent.com/Alfex4936/kakaoChatbot-Ajou/main/imgs/{choice(card_imgs)}.png",
+    )
 
-        data = Kjson.buildCard(
-            *notices[i].getAttrs("id", "title", "date", "link", "writer")
-        )
-        append(data)
 
-    # updateLastNotice(db, user_id, int(notices[0].id))
+async def getTodayNotices(day: date):
+    """최신 공지 목록 (read model) 중 날짜에 맞는 것만 return"""
+    notices, cards = readModel.cards(LATEST)
+    if notices is None:
+        return None  # 아직 한 번도 불러오지 못했다
 
-    return noticesToday
+    # 날짜는 파싱할 때 정수(toordinal)로 바꿔 뒀다. don't have to check other notices
+    return cards[: notices.leading(day.toordinal())]
 
 
-def getYesterdayNotices(db, now):
-    """어제 공지는 MySQL 데이터베이스를 통해 읽어온다."""
-    db_notices = db_model.crud.get_notices_with_date(db=db, date=now)
+async def getYesterdayNotices(db, day: date):
+    """어제 공지는 MySQL 데이터베이스를 통해 읽어온다. (date index)"""
+    db_notices = await db_model.async_crud.get_notices_with_date(db=db, date=day)
 
+    posted = day.strftime("%y.%m.%d")
     notices = []
     for notice in db_notices:
-        data = Kjson.buildCard(
-            notice.id, notice.title, notice.date, notice.link, notice.writer
+        data = cardCache.card(
+            notice.id, notice.title, posted, notice.link, notice.writer
         )
         notices.append(data)
 
     return notices  # descending ordered notices
 
 
-def getLastNotice():
-    """마지막 1개의 공지만 읽어온다."""
-    notice, _ = Homepage.parseNotices(length=1)  # Parse one notice
-    data = Kjson.buildCard(*notice[0].getAttrs("id", "title", "date", "link", "writer"))
-    return data, notice[0].date
+async def getLastNotice():
+    """마지막 1개의 공지만 읽어온다. (read model)"""
+    notice, cards = readModel.cards(LATEST)
+    if notice is None:
+        return None, None
+    return cards[0], notice.date(0)
+
+
+DAY_REPLIES = [
+    Ktemplate.buildQuickReply("어제", "어제 공지 보여줘"),
+    Ktemplate.buildQuickReply("오늘", "오늘 공지 보여줘"),
+]
 
 
-def switch(when, now, db):
+async def switch(when, day: date, db):
     """오늘/어제 공지에 따른 옵션 switch"""
     DAY = "오늘" if when == "today" else "이전"
-    notices = getTodayNotices(now) if DAY == "오늘" else getYesterdayNotices(db, now)
+    if DAY == "오늘":
+        notices = await getTodayNotices(day)
+        if notices is None:
+            return TIMEOUT_MESSAGE
+    else:
+        notices = await getYesterdayNotices(db, day)
     if not notices:
         notices = [
-            {
-                "title": "공지가 없습니다!",
-                "imageUrl": "http://k.kakaocdn.net/dn/APR96/btqqH7zLanY/kD5mIPX7TdD2NAxgP29cC0/1x1.jpg",
-            }
+            Ktemplate.buildEmptyCard(
+                "공지가 없습니다!",
+                "http://k.kakaocdn.net/dn/APR96/btqqH7zLanY/kD5mIPX7TdD2NAxgP29cC0/1x1.jpg",
+            )
         ]
 
-    data = Kjson.buildListCard(
-        title=f"{now}) {DAY} 공지",
+    data = Ktemplate.buildListCard(
+        title=f"{day:%y.%m.%d}) {DAY} 공지",
         items=notices[:5],
         buttons=[
-            {"label": "공유하기", "action": "share"},
-            {
-                "label": f"{len(notices) - 5}개 더보기" if len(notices) > 5 else "아주대학교 공지",
-                "action": "webLink",
-                "webLinkUrl": "https://www.ajou.ac.kr/kr/ajou/notice.do",
-            },
-        ],
-        quickReplies=[
-            {"messageText": "어제 공지 보여줘", "action": "message", "label": "어제"},
-            {"messageText": "오늘 공지 보여줘", "action": "message", "label": "오늘"},
+            Ktemplate.SHARE,
+            Ktemplate.buildWebLinkButton(
+                (
+                    f"{len(notices) - 5}개 더보기"
+                    if len(notices) > 5
+                    else "아주대학교 공지"
+                ),
+                "https://www.ajou.ac.kr/kr/ajou/notice.do",
+            ),
         ],
+        quickReplies=DAY_REPLIES,
     )
 
     return data
 
 
 @application.get("/")
-def hello():
+async def hello():
     return "Welcome, the server is running well."
 
 
-@application.post("/ask")
-def askKeyword(_: Dict):
-    """원하는 공지 분류를 선택하도록 유도"""
-    # user_id = content["userRequest"]["user"]["id"]  # user Id
-    # checkUserDB(user_id)
+@application.get("/stats")
+async def stats():
+    """커넥션 풀 / 캐시 상태"""
+    return {
+        "db": db_model.database.pool_stats(),
+        "http": http_pool.stats(),
+        "notice_cache": noticeCache.stats(),
+        "cards": cardCache.stats(),
+        "schedule": scheduleCache.stats(),
+        "users": userRegistry.stats(),
+        "native": nativeFrontend.stats() if nativeFrontend is not None else None,
+        "read_model": readModel.stats(),
+    }
 
-    categories = [
+
+CATEGORY_REPLIES = [
+    Ktemplate.buildQuickReply(category)
+    for category in [
         "학사",
         "학사일정",
         "비교과",
@@ -211,207 +267,217 @@ def askKeyword(_: Dict):
         "입학",
         "기타",
     ]
-    replies = [
-        {"messageText": category, "action": "message", "label": category}
-        for category in categories
-    ]
+]
+ASK_MESSAGE = Prepared(
+    Ktemplate.buildSimpleText("무슨 공지를 보고 싶으신가요?", CATEGORY_REPLIES)
+)
 
-    data = Kjson.buildSimpleText("무슨 공지를 보고 싶으신가요?", replies)
 
-    return JSONResponse(content=data)
+@application.post("/ask")
+async def askKeyword():
+    """원하는 공지 분류를 선택하도록 유도 (고정 응답, body 는 읽지 않는다)"""
+    # user_id = content["userRequest"]["user"]["id"]  # user Id
+    # checkUserDB(user_id)
+    return kakaoResponse(ASK_MESSAGE)
 
 
 @application.post("/date")
-def searchDate(content: Dict):
+async def searchDate(skill: SkillRequest = Depends(readSkill)):
     """WIP"""
-    # print(content["action"]["params"]["date"])
+    # print(skill.params["date"])
     return JSONResponse(content={})
 
 
 @application.post("/ask/filter")
 @checkUserAvailability
-def searchKeyword(content: Dict, db: Session = Depends(get_db)):
+async def searchKeyword(
+    skill: SkillRequest = Depends(readSkill), db: AsyncSession = Depends(get_db)
+):
     """유저가 카테고리를 선택하도록 유도한다. 메시지 type: ListCard"""
-    # pprint(content)
-    # print(content["action"]["params"]["cate"])
-
-    if not Homepage.checkConnection():
-        return makeTimeoutMessage()
+    # print(skill.params["cate"])
+    return kakaoResponse(categoryResponse(skill.params["cate"]))
 
-    length = 5
-
-    categories = {
-        "학사": 1,
-        "학사일정": 168,
-        "비교과": 2,
-        "장학": 3,
-        "취업": 6,
-        "사무": 7,
-        "행사": 166,
-        "파란학기제": 167,
-        "파란학기": 167,
-        "학술": 4,
-        "입학": 5,
-        "기타": 8,
-    }
-
-    user_category = content["action"]["params"]["cate"].replace(
-        " ", ""
-    )  # remove whitespace
 
-    url = f"{ADDRESS}?mode=list&srCategoryId={categories[user_category]}&srSearchKey=&srSearchVal=&articleLimit={length}&article.offset=0"
+def categoryResponse(cate):
+    """/ask/filter 응답 bytes (read model 의 카테고리 목록)"""
+    user_category = cate.replace(" ", "")  # remove whitespace
 
-    notices, noticeLength = Homepage.parseNotices(url, length)  # Parse notices
-    if noticeLength == 0:
-        return makeTimeoutMessage()
-    notices = []
+    _, cards = readModel.cards(CATEGORIES[user_category], putDate=True)
+    if cards is None:
+        return TIMEOUT_MESSAGE
 
-    for i in range(noticeLength):
-        data = Kjson.buildCard(
-            *notices[i].getAttrs("id", "title", "date", "link", "writer") + [True],
-        )
-        notices.append(data)
-
-    data = Kjson.buildListCard(
+    return Ktemplate.buildListCard(
         title=f"{user_category} 공지",
-        items=notices[:5],
+        items=cards[:5],
         buttons=[
-            {"label": "공유하기", "action": "share"},
-            {
-                "label": user_category,
-                "action": "webLink",
-                "webLinkUrl": f"https://www.ajou.ac.kr/kr/ajou/notice.do?mode=list&srCategoryId={categories[user_category]}",
-            },
+            Ktemplate.SHARE,
+            Ktemplate.buildWebLinkButton(
+                user_category,
+                f"https://www.ajou.ac.kr/kr/ajou/notice.do?mode=list&srCategoryId={CATEGORIES[user_category]}",
+            ),
         ],
         quickReplies=None,
     )
 
-    return JSONResponse(content=data)
-
 
 @application.post("/last")
 @checkUserAvailability
-def parseOne(content: Dict, db: Session = Depends(get_db)):
+async def parseOne(
+    skill: SkillRequest = Depends(readSkill), db: AsyncSession = Depends(get_db)
+):
     """지난 최근 마지막 공지 1개만 읽어온다. 메시지 type: ListCard"""
-    if not Homepage.checkConnection():
-        return makeTimeoutMessage()
+    return kakaoResponse(await lastResponse())
 
-    notice, date = getLastNotice()
 
-    data = Kjson.buildListCard(
+async def lastResponse():
+    """/last 응답 bytes (native 모드에서는 미리 발행한다)"""
+    notice, date = await getLastNotice()
+    if notice is None:
+        return TIMEOUT_MESSAGE
+
+    return Ktemplate.buildListCard(
         title=f"{date} 공지",
         items=[notice],
-        buttons=[
-            {"label": "공유하기", "action": "share"},
-        ],
+        buttons=[Ktemplate.SHARE],
         quickReplies=None,
     )
 
-    return JSONResponse(content=data)
+
+SEARCH_REPLIES = [
+    Ktemplate.buildQuickReply("등록금 검색"),
+    Ktemplate.buildQuickReply("이벤트 검색"),
+    Ktemplate.buildQuickReply("코로나 검색"),
+]
 
 
 @application.post("/search")
 @checkUserAvailability
-def searchNotice(content: Dict, db: Session = Depends(get_db)):
+async def searchNotice(
+    skill: SkillRequest = Depends(readSkill), db: AsyncSession = Depends(get_db)
+):
     """유저의 키워드에 맞는 공지를 불러온다. 메시지 type: simpleText | ListCard"""
     if not Homepage.checkConnection():
         return makeTimeoutMessage()
 
-    # pprint(content)
-    content = content["action"]["params"]
+    content = skill.params
     if not "sys_text" in content:
-        qr = [
-            {
-                "messageText": "2021 검색",
-                "action": "message",
-                "label": "2021 검색",
-            },
-        ]
+        qr = [Ktemplate.buildQuickReply("2021 검색")]
 
-        return JSONResponse(
-            content=Kjson.buildSimpleText("2021 검색과 같이 검색어를 같이 입력하세요.", qr)
+        return kakaoResponse(
+            Ktemplate.buildSimpleText("2021 검색과 같이 검색어를 같이 입력하세요.", qr)
         )
     keyword = content["sys_text"]
     length = 7
     url = f"{ADDRESS}?mode=list&srSearchKey=&srSearchVal={quote(keyword.strip())}&articleLimit={length}&article.offset=0"
 
-    notices, noticeLength = Homepage.parseNotices(url, length)  # Parse notices
+    notices, noticeLength = await Homepage.aparseNotices(url, length)  # Parse notices
     if noticeLength == 0:
-        return JSONResponse(content=Kjson.buildSimpleText(f"{keyword}에 관한 글이 없어요."))
-    notices = []
-
-    for i in range(noticeLength):
-        data = Kjson.buildCard(
-            *notices[i].getAttrs("id", "title", "date", "link", "writer") + [True]
+        return kakaoResponse(
+            Ktemplate.buildSimpleText(f"{keyword}에 관한 글이 없어요.")
         )
-        notices.append(data)
+    cards = notices.to_cards(put_date=True)
 
-    data = Kjson.buildListCard(
+    data = Ktemplate.buildListCard(
         title=f"{keyword[:12]} 결과",
-        items=notices[:5],
+        items=cards[:5],
         buttons=[
-            {"label": "공유하기", "action": "share"},
-            {
-                "label": "더보기" if len(notices) > 5 else "홈페이지 보기",
-                "action": "webLink",
-                "webLinkUrl": f"https://www.ajou.ac.kr/kr/ajou/notice.do?mode=list&srSearchKey=&srSearchVal={quote(keyword)}",
-            },
-        ],
-        quickReplies=[
-            {"messageText": "등록금 검색", "action": "message", "label": "등록금 검색"},
-            {"messageText": "이벤트 검색", "action": "message", "label": "이벤트 검색"},
-            {"messageText": "코로나 검색", "action": "message", "label": "코로나 검색"},
+            Ktemplate.SHARE,
+            Ktemplate.buildWebLinkButton(
+                "더보기" if len(cards) > 5 else "홈페이지 보기",
+                f"https://www.ajou.ac.kr/kr/ajou/notice.do?mode=list&srSearchKey=&srSearchVal={quote(keyword)}",
+            ),
         ],
+        quickReplies=SEARCH_REPLIES,
     )
 
-    return JSONResponse(content=data)
+    return kakaoResponse(data)
 
 
 @application.post("/message")
 @checkUserAvailability
-def message(content: Dict, db: Session = Depends(get_db)):
+async def message(
+    skill: SkillRequest = Depends(readSkill), db: AsyncSession = Depends(get_db)
+):
     """어제/오늘 공지 불러오기 위한 route | 메시지 type: ListCard"""
-    if not Homepage.checkConnection():
-        return makeTimeoutMessage()
+    # data = skill.utterance 발화문
+    return kakaoResponse(await messageResponse(skill.params["when"], db))
 
-    # data = content["userRequest"]["utterance"] 발화문
-    when = content["action"]["params"]["when"]
 
-    now = datetime.now()
-    if when == "today":
-        now = now.strftime("%y.%m.%d")
-    elif when == "yesterday":
-        now = now - timedelta(days=1)
-        now = now.strftime("%y.%m.%d")
+async def messageResponse(when, db):
+    """/message 응답 bytes (native 모드에서는 today/yesterday 를 미리 발행한다)"""
+    day = date.today()
+    if when == "yesterday":
+        day -= timedelta(days=1)
 
-    response_data = switch(when, now, db)
+    return await switch(when, day, db)
 
-    return JSONResponse(content=response_data)
 
+SCHEDULE_VARIANTS = 3  # 썸네일을 랜덤으로 고른 응답 몇 개를 만들어 둔다
 
-@application.post("/schedule")
-@checkUserAvailability
-def schedule(content: Dict, db: Session = Depends(get_db)):
-    """MySQL DB 학사일정 불러오기 | 메시지 type: Carousel BasicCards"""
 
-    cards = []
-    append = cards.append
+async def loadSchedule():
+    """학사일정 carousel 응답 bytes 들 (scheduleCache 가 부른다)"""
+    async with db_model.database.AsyncSessionLocal() as db:
+        scheds = (await getSchedule(db=db))[:10]
 
-    scheds = getSchedule(db=db)
-    for sched in scheds:
-        append(
-            makeCarouselCard(sched.content, f"{sched.start_date} ~ {sched.end_date}")
+    return [
+        Prepared(
+            Ktemplate.buildCarousel(
+                [
+                    makeCarouselCard(
+                        sched.content, f"{sched.start_date} ~ {sched.end_date}"
+                    )
+                    for sched in scheds
+                ]
+            )
         )
+        for _ in range(SCHEDULE_VARIANTS)
+    ]
+
 
-    content = {
-        "version": "2.0",
-        "template": {
-            "outputs": [{"carousel": {"type": "basicCard", "items": cards[:10]}}],
+@application.post("/schedule")
+@checkUserAvailability
+async def schedule(skill: SkillRequest = Depends(readSkill)):
+    """MySQL DB 학사일정 불러오기 | 메시지 type: Carousel BasicCards"""
+    return kakaoResponse(await scheduleCache.aget(loadSchedule))
+
+
+async def nativeTable():
+    """native 모드에서 C 가 바로 보낼 응답 {key: (bodies, track)}
+
+    key 는 경로, params 가 문자열 하나면 "경로?name=value".
+    track 이면 그 요청의 user.id 를 userRegistry 에 넘긴다. (checkUserAvailability)
+    /search 처럼 입력마다 다른 응답은 넣지 않는다. (FastAPI 가 처리)
+    """
+    async with db_model.database.AsyncSessionLocal() as db:
+        today = await messageResponse("today", db)
+        yesterday = await messageResponse("yesterday", db)
+
+    return {
+        "/ask": ([ASK_MESSAGE], False),
+        "/last": ([await lastResponse()], True),
+        "/message?when=today": ([today], True),
+        "/message?when=yesterday": ([yesterday], True),
+        "/schedule": (await scheduleCache.abodies(loadSchedule), True),
+        **{
+            f"/ask/filter?cate={cate}": ([categoryResponse(cate)], True)
+            for cate in CATEGORIES
         },
     }
 
-    return JSONResponse(content=content)
-
 
 if __name__ == "__main__":
-    uvicorn.run(application, host="0.0.0.0", port=8000, log_level="info")
+    if prefork.WORKERS > 0:
+        prefork.Supervisor(
+            application,
+            nativeTable,
+            userRegistry,
+            prefork.WORKERS,
+            NATIVE_HTTP,
+            model=readModel,
+        ).run("0.0.0.0", 8000)
+    elif NATIVE_HTTP and NativeFrontend.available():
+        nativeFrontend = NativeFrontend(application, nativeTable, userRegistry.ensure)
+        nativeFrontend.run("0.0.0.0", 8000)
+    else:
+        uvicorn.run(application, host="0.0.0.0", port=8000, log_level="info")
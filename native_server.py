@@ -0,0 +1,238 @@
+"""ajou_native.Server 로 웹훅을 받는 모드 (uvicorn 대신)
+
+캐시로 답할 수 있는 응답 (/ask, /last, /message 오늘/어제, /schedule) 은 Python 이
+refresh 초마다 미리 만들어 Server.publish() 로 넘기고, C 루프가 GIL 없이 바로 보낸다.
+표에 없는 요청 (/search, /ask/filter, GET /stats ...) 은 같은 FastAPI app 을
+ASGI 로 직접 불러서 답한다. C 가 바로 보낸 요청의 user.id 는 drain_users() 로
+받아서 onUser (UserRegistry.ensure) 에 넘긴다.
+
+Usage
+-----
+    if NATIVE_HTTP and NativeFrontend.available():
+        NativeFrontend(application, buildTable, userRegistry.ensure).run("0.0.0.0", 8000)
+
+환경 변수
+    KAKAO_NATIVE_HTTP     1 이면 kakao.py 가 uvicorn 대신 이 모드로 뜬다
+    KAKAO_NATIVE_REFRESH  응답 표를 다시 만드는 주기(초) (default 5)
+"""
+
+import asyncio
+import os
+import signal
+import threading
+from http import HTTPStatus
+from urllib.parse import unquote
+
+from raw_response import Prepared
+from skill_request import MAX_BODY
+
+try:
+    from ajou_native import Server
+except ImportError:  # not built, or not Linux
+    Server = None
+
+NATIVE_HTTP = os.environ.get("KAKAO_NATIVE_HTTP") == "1"
+NATIVE_REFRESH = float(os.environ.get("KAKAO_NATIVE_REFRESH", 5.0))
+DRAIN_INTERVAL = 1.0  # drain_users() 주기(초)
+
+_SKIPPED_HEADERS = (b"content-length", b"transfer-encoding", b"connection")
+
+
+def _body(body):
+    return body.body if isinstance(body, Prepared) else bytes(body)
+
+
+def encodeTable(table):
+    """{key: (bodies, track)} 의 body 를 bytes 로 (Prepared 도 받는다)"""
+    return {
+        key: ([_body(body) for body in bodies], track)
+        for key, (bodies, track) in table.items()
+    }
+
+
+def _encode(status, headers, body):
+    """HTTP/1.1 응답 전체 bytes (Content-Length 는 여기서 다시 붙인다)"""
+    try:
+        phrase = HTTPStatus(status).phrase
+    except ValueError:
+        phrase = ""
+    lines = [f"HTTP/1.1 {status} {phrase}".encode("latin-1")]
+    lines.extend(
+        name + b": " + value
+        for name, value in headers
+        if name.lower() not in _SKIPPED_HEADERS
+    )
+    lines.append(b"content-length: " + str(len(body)).encode("latin-1"))
+    return b"\r\n".join(lines) + b"\r\n\r\n" + body
+
+
+class Lifespan:
+    """app 의 startup/shutdown 이벤트를 ASGI lifespan 으로 부른다."""
+
+    __slots__ = ("app", "state", "_events", "_acks", "_task")
+
+    def __init__(self, app):
+        self.app = app
+        self.state = {}
+        self._events = asyncio.Queue()
+        self._acks = asyncio.Queue()
+        self._task = None
+
+    async def _call(self, name):
+        await self._events.put({"type": f"lifespan.{name}"})
+        message = await self._acks.get()
+        if message["type"].endswith(".failed"):
+            raise RuntimeError(message.get("message", f"lifespan {name} failed"))
+
+    async def startup(self):
+        scope = {"type": "lifespan", "asgi": {"version": "3.0"}, "state": self.state}
+        self._task = asyncio.ensure_future(
+            self.app(scope, self._events.get, self._acks.put)
+        )
+        await self._call("startup")
+
+    async def shutdown(self):
+        await self._call("shutdown")
+        await self._task
+
+
+class NativeFrontend:
+    """
+    Methods
+    -------
+    available() -> bool  (static)
+    run(host, port)
+    stats() -> dict
+    """
+
+    __slots__ = ("app", "build", "onUser", "refresh", "server", "_host", "_tasks")
+
+    def __init__(self, app, build, onUser=None, refresh=NATIVE_REFRESH):
+        self.app = app
+        self.build = build  # async () -> {key: (bodies, track)} | None (그대로 둔다)
+        self.onUser = onUser
+        self.refresh = refresh
+        self.server = None
+        self._host = None
+        self._tasks = set()  # 처리 중인 fallback 요청
+
+    @staticmethod
+    def available():
+        return Server is not None
+
+    def run(self, host="0.0.0.0", port=8000, reusePort=False):
+        self.server = Server(host, port, max_body=MAX_BODY, reuse_port=reusePort)
+        self._host = (host, port)
+        print(f"Native front-end on http://{host}:{port}")
+        try:
+            asyncio.run(self._main())
+        except KeyboardInterrupt:
+            print("Pressed CTRL+C...")
+
+    def stats(self):
+        return self.server.stats() if self.server is not None else {}
+
+    async def _main(self):
+        loop = asyncio.get_running_loop()
+        if threading.current_thread() is threading.main_thread():
+            loop.add_signal_handler(signal.SIGTERM, asyncio.current_task().cancel)
+        lifespan = Lifespan(self.app)
+        await lifespan.startup()
+        await self._publish()  # 첫 표는 요청을 받기 전에
+
+        serving = threading.Thread(target=self.server.serve_forever, daemon=True)
+        pump = threading.Thread(target=self._pump, args=(loop,), daemon=True)
+        serving.start()
+        pump.start()
+        try:
+            await asyncio.gather(self._publishing(), self._draining())
+        except asyncio.CancelledError:
+            print("Terminated...")
+        finally:
+            self.server.stop()
+            serving.join()
+            pump.join()
+            self._drain()
+            await lifespan.shutdown()
+
+    def _pump(self, loop):
+        """next() 로 받은 요청을 event loop 의 task 로 넘긴다. (stop() 이면 None)"""
+        while (request := self.server.next()) is not None:
+            loop.call_soon_threadsafe(self._spawn, request)
+
+    def _spawn(self, request):
+        task = asyncio.ensure_future(self._handle(*request))
+        self._tasks.add(task)
+        task.add_done_callback(self._tasks.discard)
+
+    async def _publish(self):
+        try:
+            table = await self.build()
+            if table is not None:
+                self.server.publish(encodeTable(table))
+        except Exception as e:  # 지난 표를 그대로 쓴다
+            print(f"Native table failed: {e}")
+
+    async def _publishing(self):
+        while True:
+            await asyncio.sleep(self.refresh)
+            await self._publish()
+
+    def _drain(self):
+        users = self.server.drain_users()
+        if self.onUser is not None:
+            for user in users:
+                self.onUser(user)
+
+    async def _draining(self):
+        while True:
+            await asyncio.sleep(DRAIN_INTERVAL)
+            self._drain()
+
+    async def _handle(self, token, head, body):
+        """표에 없는 요청: FastAPI app 을 ASGI 로 부르고 응답을 reply() 한다."""
+        method, target, headers = head
+        path, _, query = target.partition(b"?")
+        scope = {
+            "type": "http",
+            "asgi": {"version": "3.0"},
+            "http_version": "1.1",
+            "method": method,
+            "scheme": "http",
+            "path": unquote(path.decode("latin-1")),
+            "raw_path": path,
+            "query_string": query,
+            "root_path": "",
+            "headers": headers,
+            "client": None,
+            "server": self._host,
+            "state": {},
+        }
+        done = asyncio.Event()
+        sent = {"body": False}
+        status, responseHeaders, chunks = 500, [], []
+
+        async def receive():
+            if not sent["body"]:
+                sent["body"] = True
+                return {"type": "http.request", "body": body, "more_body": False}
+            await done.wait()
+            return {"type": "http.disconnect"}
+
+        async def send(message):
+            nonlocal status, responseHeaders
+            if message["type"] == "http.response.start":
+                status = message["status"]
+                responseHeaders = message.get("headers", [])
+            elif message["type"] == "http.response.body":
+                chunks.append(message.get("body", b""))
+
+        try:
+            await self.app(scope, receive, send)
+            response = _encode(status, responseHeaders, b"".join(chunks))
+        except Exception as e:
+            print(f"Native fallback failed: {e}")
+            response = _encode(500, [], b"Internal Server Error")
+        finally:
+            done.set()
+        self.server.reply(token, response)
@@ -0,0 +1,163 @@
+"""공지 목록 캐시 (URL -> 파싱 결과)
+
+같은 URL 을 ttl 안에 다시 요청하면 홈페이지에 가지 않는다.
+get() 은 스레드용, aget() 은 asyncio 용이고 저장소는 같이 쓴다.
+
+    fresh   age < ttl              캐시 값 그대로
+    stale   age < ttl + stale      캐시 값을 주고, 백그라운드에서 한 번만 갱신
+    expired 그 이후 / 없음          한 요청만 불러오고 나머지는 그 결과를 기다린다
+
+환경 변수
+    AJOU_CACHE_TTL    (default 60초)
+    AJOU_CACHE_STALE  (default 300초)
+    AJOU_CACHE_SIZE   최대 URL 수 (default 256)
+"""
+
+import asyncio
+import os
+import threading
+import time
+from collections import OrderedDict
+
+from http_pool import AsyncSingleFlight, SingleFlight
+
+CACHE_TTL = float(os.environ.get("AJOU_CACHE_TTL", 60.0))
+CACHE_STALE = float(os.environ.get("AJOU_CACHE_STALE", 300.0))
+CACHE_SIZE = int(os.environ.get("AJOU_CACHE_SIZE", 256))
+
+
+class _Entry:
+    __slots__ = ("value", "stored")
+
+    def __init__(self, value):
+        self.value = value
+        self.stored = time.monotonic()
+
+
+class NoticeCache:
+    """
+    Methods
+    -------
+    get(key, loader) -> value
+    aget(key, loader) -> value  (await, loader() 는 awaitable)
+    invalidate(key=None)
+    stats() -> dict
+    """
+
+    __slots__ = (
+        "ttl",
+        "stale",
+        "maxsize",
+        "cacheable",
+        "_entries",
+        "_flights",
+        "_aflights",
+        "_lock",
+        "_tasks",
+        "hits",
+        "stale_hits",
+        "misses",
+        "refreshes",
+    )
+
+    def __init__(
+        self,
+        ttl=CACHE_TTL,
+        stale=CACHE_STALE,
+        maxsize=CACHE_SIZE,
+        cacheable=lambda value: value is not None,
+    ):
+        self.ttl = ttl
+        self.stale = stale
+        self.maxsize = maxsize
+        self.cacheable = cacheable  # 실패 결과는 저장하지 않는다
+        self._entries = OrderedDict()
+        self._flights = SingleFlight()
+        self._aflights = AsyncSingleFlight()
+        self._lock = threading.Lock()
+        self._tasks = set()  # 백그라운드 갱신 (loop 는 task 를 weakref 로만 들고 있다)
+        self.hits = self.stale_hits = self.misses = self.refreshes = 0
+
+    def _lookup(self, key):
+        """(entry, stale) 를 돌려준다. 없거나 너무 오래됐으면 (None, False)"""
+        with self._lock:
+            entry = self._entries.get(key)
+            if entry is not None:
+                age = time.monotonic() - entry.stored
+                if age < self.ttl:
+                    self.hits += 1
+                    self._entries.move_to_end(key)
+                    return entry, False
+                if age < self.ttl + self.stale:
+                    self.stale_hits += 1
+                    return entry, True
+            self.misses += 1
+            return None, False
+
+    def get(self, key, loader):
+        entry, stale = self._lookup(key)
+        if entry is not None:
+            if stale and not self._flights.pending(key):
+                self.refreshes += 1
+                threading.Thread(
+                    target=self._refresh, args=(key, loader), daemon=True
+                ).start()
+            return entry.value
+
+        return self._flights.do(key, lambda: self._load(key, loader))
+
+    async def aget(self, key, loader):
+        entry, stale = self._lookup(key)
+        if entry is not None:
+            if stale and not self._aflights.pending(key):
+                self.refreshes += 1
+                task = asyncio.ensure_future(self._arefresh(key, loader))
+                self._tasks.add(task)
+                task.add_done_callback(self._tasks.discard)
+            return entry.value
+
+        return await self._aflights.do(key, lambda: self._aload(key, loader))
+
+    def _load(self, key, loader):
+        return self._store(key, loader())
+
+    def _store(self, key, value):
+        if self.cacheable(value):
+            with self._lock:
+                self._entries[key] = _Entry(value)
+                self._entries.move_to_end(key)
+                while len(self._entries) > self.maxsize:
+                    self._entries.popitem(last=False)
+        return value
+
+    async def _aload(self, key, loader):
+        return self._store(key, await loader())
+
+    async def _arefresh(self, key, loader):
+        try:
+            await self._aflights.do(key, lambda: self._aload(key, loader))
+        except Exception as e:  # 다음 요청이 stale 값을 계속 쓴다
+            print(f"Cache refresh {key} failed: {e!r}")
+
+    def _refresh(self, key, loader):
+        try:
+            self._flights.do(key, lambda: self._load(key, loader))
+        except Exception as e:  # 다음 요청이 stale 값을 계속 쓴다
+            print(f"Cache refresh {key} failed: {e!r}")
+
+    def invalidate(self, key=None):
+        with self._lock:
+            if key is None:
+                self._entries.clear()
+            else:
+                self._entries.pop(key, None)
+
+    def stats(self):
+        with self._lock:
+            return {
+                "size": len(self._entries),
+                "hits": self.hits,
+                "stale_hits": self.stale_hits,
+                "misses": self.misses,
+                "refreshes": self.refreshes,
+            }
@@ -1,9 +1,22 @@
-import ssl
 from urllib.error import HTTPError, URLError
-from urllib.request import urlopen
 
-from selectolax.parser import HTMLParser
-from typed_python import Class, Final, Forward, ListOf, Member
+import health
+from card_cache import CardCache
+from http_pool import AsyncSingleFlight, SingleFlight, afetch, fetch
+from notice_cache import NoticeCache
+from notice_scan import load_batch, scan_batch
+from read_model import ReadModel
+
+HOST = "www.ajou.ac.kr"
+ADDRESS = "https://www.ajou.ac.kr/kr/ajou/notice.do"
+
+# (None, 0) 은 실패/빈 목록이므로 저장하지 않는다.
+noticeCache = NoticeCache(cacheable=lambda result: result[0] is not None)
+# 캐시를 거치지 않는 호출도 같은 URL 이면 fetch + 파싱을 한 번만 한다.
+noticeFlights = SingleFlight()
+noticeAsyncFlights = AsyncSingleFlight()
+# DB 에서 읽은 공지의 카드 (홈페이지 목록의 카드는 read model 이 목록이 바뀔 때 만든다)
+cardCache = CardCache()
 
 
 class Homepage:
@@ -11,160 +24,97 @@ class Homepage:
 
     @staticmethod
     def checkConnection():
-        """홈페이지 반응을 체크한다."""
-        context = ssl._create_unverified_context()
-        try:
-            urlopen(
-                url="https://www.ajou.ac.kr/kr/ajou/notice.do",
-                timeout=2.0,
-                context=context,
-            )
-        except HTTPError:
-            print("Seems like the server is down now.")
-            return False
-        except URLError:
-            print("Seems like the url is wrong now.")
-            return False
-        except TimeoutError:
-            print("It's taking too long to load website.")
-            return False
-        return True  # the connection automatically is closed
+        """홈페이지 반응을 체크한다. (I/O 없이 최근 fetch/probe 결과만 본다)"""
+        return health.upstream(HOST).is_alive()
 
     @staticmethod
-    def parseNotices(url=None, length=10):
-        ADDRESS = "https://www.ajou.ac.kr/kr/ajou/notice.do"
+    def startHealthProbe(interval=health.PROBE_INTERVAL):
+        """요청이 없을 때도 상태가 갱신되도록 가벼운 probe 를 띄운다."""
+        return health.upstream(HOST).start_probe(
+            lambda: fetch(f"{ADDRESS}?mode=list&articleLimit=1", timeout=2.0),
+            interval,
+        )
 
-        """공지 파서 메인
+    @staticmethod
+    def parseNotices(url=None, length=10):
+        """공지 파서 메인 (캐시)
 
         Args:
             url (str, optional): 홈페이지 URL (with admin options). Defaults to None.
             length (int, optional): 몇 개의 공지를 읽을 것인가. Defaults to 10.
 
         Returns:
-            ids, posts, dates, writers, length (list, optional): length에 따른 공지 목록을 전부 불러온다.
+            notices, length (NoticeBatch, int): length에 따른 공지 목록을 전부 불러온다.
+            캐시된 목록은 여러 요청이 공유하므로 수정하지 않는다.
         """
         if url is None:
             url = f"{ADDRESS}?mode=list&articleLimit={length}&article.offset=0"
 
-        context = ssl._create_unverified_context()
+        return noticeCache.get(url, lambda: Homepage.fetchNotices(url))
+
+    @staticmethod
+    def fetchNotices(url):
+        """캐시 없이 url 을 불러와서 파싱한다. 동시에 같은 url 이면 결과를 공유한다."""
+        return noticeFlights.do(url, lambda: Homepage._fetchNotices(url))
+
+    @staticmethod
+    def _fetchNotices(url):
         try:
-            result = urlopen(url, timeout=2.0, context=context)
+            result = fetch(url, timeout=2.0)
         except HTTPError:
             print("Seems like the server is down now.")
             return None, 0  # make entity
+        except URLError:
+            print("Seems like the url is wrong now.")
+            return None, 0  # make entity
         except TimeoutError:
             print("It's taking too long to load website.")
             return None, 0  # make entity
 
-        html = result.read().decode("utf-8")
-        soup = HTMLParser(html)
-        no_post = soup.css_first("td.b-no-post")
-        if no_post:
-            return None, 0  # make entity
-
-        ids = soup.css("td.b-num-box")
-        posts = soup.css("div.b-title-box > a")
-        # links will be generated by posts[i] href
-        dates = soup.css("span.b-date")
-        writers = soup.css("span.b-writer")
-        length = len(ids)
-
-        ids = soup.css("td.b-num-box")
-        posts = soup.css("div.b-title-box > a")
-        dates = soup.css("span.b-date")
-        writers = soup.css("span.b-writer")
-
-        notices = ListOf(Notice)()
-
-        for i in range(length):
-            title = posts[i].text(strip=True)
-            writer = writers[i].text(strip=False)
-
-            duplicate = "[" + writer + "]"
-            if duplicate in title:  # writer: [writer] title
-                title = title.replace(duplicate, "").strip()  # -> writer: title
-
-            notice = Notice(
-                ids[i].text(strip=True),
-                title,
-                dates[i].text(strip=True),
-                writer,
-                ADDRESS + posts[i].attributes["href"],
-            )
-            notices.append(notice)
-
-        return notices, length
-
-
-init = Forward("ClassWithInit")
+        return Homepage.toNotices(result.body)
 
+    @staticmethod
+    async def aparseNotices(url=None, length=10):
+        """parseNotices() 의 asyncio 버전 (같은 캐시를 쓴다)"""
+        if url is None:
+            url = f"{ADDRESS}?mode=list&articleLimit={length}&article.offset=0"
 
-@init.define
-class Notice(Class, Final):
-    # __slots__ = ("_id", "_post", "_date", "_link", "_writer")
-    _id = Member(str)
-    _post = Member(str)
-    _date = Member(str)
-    _writer = Member(str)
-    _link = Member(str)
-
-    def __init__(self, id, post, date, writer, link):
-        self._id = id
-        self._post = post
-        self._date = date
-        self._writer = writer
-        self._link = link
-
-    def getAttrs(self, *attrs):
-        result = [None] * len(attrs)
-        if not attrs:
-            return result
-
-        for i, attr in enumerate(attrs):
-            result[i] = getattr(self, attr)
-
-        return result
-
-    @property
-    def id(self):
-        return self._id
-
-    @id.setter
-    def id(self, id):
-        self._id = id
-
-    @property
-    def title(self):
-        return self._post
+        return await noticeCache.aget(url, lambda: Homepage.afetchNotices(url))
 
-    @title.setter
-    def title(self, title):
-        self._post = title
+    @staticmethod
+    async def afetchNotices(url):
+        return await noticeAsyncFlights.do(url, lambda: Homepage._afetchNotices(url))
 
-    @property
-    def date(self):
-        return self._date
+    @staticmethod
+    async def _afetchNotices(url):
+        try:
+            result = await afetch(url, timeout=2.0)
+        except HTTPError:
+            print("Seems like the server is down now.")
+            return None, 0  # make entity
+        except URLError:
+            print("Seems like the url is wrong now.")
+            return None, 0  # make entity
+        except TimeoutError:
+            print("It's taking too long to load website.")
+            return None, 0  # make entity
 
-    @date.setter
-    def date(self, date):
-        self._date = date
+        return Homepage.toNotices(result.body)
 
-    @property
-    def writer(self):
-        return self._writer
+    @staticmethod
+    def toNotices(html):
+        """notice.do HTML -> (NoticeBatch, length)"""
+        notices = scan_batch(html, ADDRESS)  # 한 번만 훑고 arena 하나에 담는다
+        length = len(notices)
+        if length == 0:
+            return None, 0  # make entity
 
-    @writer.setter
-    def writer(self, writer):
-        self._writer = writer
+        return notices, length
 
-    @property
-    def link(self):
-        return self._link
 
-    @link.setter
-    def link(self, link):
-        self._link = link
+async def _ingestBody(url, timeout):
+    return (await afetch(url, timeout=timeout)).body
 
 
-if __name__ == "__main__":
-    notice = Notice("2020", "title", "date", "writer", "link")
+# 백그라운드 ingest 가 채우는 최신/카테고리 목록 (핸들러는 여기서만 읽는다)
+readModel = ReadModel(ADDRESS, _ingestBody, Homepage.toNotices, load_batch)
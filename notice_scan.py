@@ -0,0 +1,150 @@
+"""공지 목록 HTML 스캐너
+
+ajou_native (C 확장, setup.py 로 빌드) 가 있으면 DOM 없이 한 번에 훑고,
+없으면 selectolax 로 같은 결과를 만든다.
+
+scan_notices(html: bytes) -> [(id, title, date, writer, href, category), ...]
+scan_batch(html: bytes, address: str) -> NoticeBatch
+    len(batch), batch.id(i) (int, 고정 공지는 0) / day(i)
+    batch.title(i) / date(i) / writer(i) / link(i)
+    batch.row(i) -> (id, title, date, link, writer)
+    batch.leading(day) -> 앞에서부터 day 가 같은 공지 수
+    batch.to_cards(stop=-1, put_date=False) -> [Ktemplate.buildCard bytes, ...]
+    batch.dump() -> bytes
+load_batch(data: bytes) -> NoticeBatch
+    dump() 를 다시 훑지 않고 되돌린다. (publisher -> pre-fork 워커)
+to_day(text: str) -> int
+    "21.03.01" -> date(2021, 3, 1).toordinal(), 모르는 형식은 0
+"""
+
+try:
+    from ajou_native import NoticeBatch, load_batch, scan_batch, scan_notices, to_day
+except ImportError:  # not built
+    import marshal
+    import re
+    from datetime import date
+
+    from selectolax.parser import HTMLParser
+
+    from json_model import Ktemplate
+
+    def scan_notices(html):
+        if isinstance(html, (bytes, bytearray, memoryview)):
+            html = bytes(html).decode("utf-8", "replace")
+
+        soup = HTMLParser(html)
+        if soup.css_first("td.b-no-post"):
+            return []
+
+        ids = soup.css("td.b-num-box")
+        posts = soup.css("div.b-title-box > a")
+        dates = soup.css("span.b-date")
+        writers = soup.css("span.b-writer")
+        cates = soup.css("span.b-cate")
+
+        return [
+            (
+                ids[i].text(strip=True),
+                posts[i].text(strip=True),
+                dates[i].text(strip=True),
+                writers[i].text(strip=False),
+                posts[i].attributes["href"] or "",
+                cates[i].text(strip=True) if i < len(cates) else "",
+            )
+            for i in range(len(ids))
+        ]
+
+    _DAY = re.compile(r"[ \t\n\r\f]*(\d{1,4})[./-](\d{1,2})[./-](\d{1,2})[ \t\n\r\f]*")
+
+    def to_day(text):
+        match = _DAY.fullmatch(text)
+        if match is None or not text.isascii():
+            return 0
+        year, month, day = (int(g) for g in match.groups())
+        if len(match.group(1)) <= 2:
+            year += 2000
+        try:
+            return date(year, month, day).toordinal()
+        except ValueError:
+            return 0
+
+    class NoticeBatch:
+        """ajou_native.NoticeBatch 와 같은 인터페이스 (열마다 list)"""
+
+        __slots__ = ("_id", "_day", "_title", "_date", "_writer", "_link")
+
+        def __init__(self, rows=(), address=""):
+            self._id, self._day, self._title, self._date = [], [], [], []
+            self._writer, self._link = [], []
+            for id, title, date, writer, href, _ in rows:
+                duplicate = "[" + writer + "]"
+                if duplicate in title:  # writer: [writer] title
+                    title = title.replace(duplicate, "").strip()  # -> writer: title
+                id = id.strip(" \t\n\r\f")
+                self._id.append(int(id) if id.isascii() and id.isdigit() else 0)
+                self._day.append(to_day(date))
+                self._title.append(title)
+                self._date.append(date)
+                self._writer.append(writer)
+                self._link.append(address + href)
+
+        def __len__(self):
+            return len(self._id)
+
+        def id(self, i):
+            return self._id[i]
+
+        def day(self, i):
+            return self._day[i]
+
+        def title(self, i):
+            return self._title[i]
+
+        def date(self, i):
+            return self._date[i]
+
+        def writer(self, i):
+            return self._writer[i]
+
+        def link(self, i):
+            return self._link[i]
+
+        def row(self, i):
+            return (
+                self._id[i],
+                self._title[i],
+                self._date[i],
+                self._link[i],
+                self._writer[i],
+            )
+
+        def leading(self, day):
+            for i, d in enumerate(self._day):
+                if d != day:
+                    return i
+            return len(self._day)
+
+        def to_cards(self, stop=-1, put_date=False):
+            if stop < 0 or stop > len(self):
+                stop = len(self)
+            return [Ktemplate.buildCard(*self.row(i), put_date) for i in range(stop)]
+
+        def dump(self):
+            return marshal.dumps(
+                (self._id, self._day, self._title, self._date, self._writer, self._link)
+            )
+
+    def scan_batch(html, address):
+        return NoticeBatch(scan_notices(html), address)
+
+    def load_batch(data):
+        batch = NoticeBatch()
+        (
+            batch._id,
+            batch._day,
+            batch._title,
+            batch._date,
+            batch._writer,
+            batch._link,
+        ) = marshal.loads(data)
+        return batch
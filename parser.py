@@ -1,23 +1,30 @@
-import ssl
+import hashlib
 import time
 from contextlib import contextmanager
 from dataclasses import dataclass
-from datetime import datetime, timedelta
+from datetime import date, datetime, timedelta
 from enum import Enum
 from typing import List, Optional
-from urllib.error import HTTPError
+from urllib.error import HTTPError, URLError
 from urllib.parse import quote
-from urllib.request import urlopen
 
 from pytz import timezone
-from selectolax.parser import HTMLParser
 
 import db_model.crud
 import db_model.database
+import db_model.migrate
 import db_model.models
 import db_model.schemas
+from backfill import Backfill
+from categories import CATEGORIES, CATEGORY_IDS
+from crawler import Crawler
+from http_pool import SingleFlight, fetch
+from notice_scan import scan_notices, to_day
+from retention import RetentionManager
 
 db_model.models.Base.metadata.create_all(bind=db_model.database.engine)
+db_model.migrate.upgrade(db_model.database.engine)
+
 
 # Dependency
 @contextmanager
@@ -34,6 +41,7 @@ class Error(Enum):
     INVALID_URL = 2
     NO_NOTICE = 3
     INVALID_CATEGORY = 4
+    NOT_MODIFIED = 5
 
 
 @dataclass
@@ -42,29 +50,16 @@ class Notice:
     title: str
     category: str
     writer: str
-    date: str
+    date: Optional[date]
     link: str
 
 
 class NoticeFilter:
     BASIC_URL = "https://www.ajou.ac.kr/kr/ajou/notice.do?mode=list&article.offset=0&articleLimit=15"
 
-    CATEGORIES = {
-        "학사": 1,
-        "비교과": 2,
-        "장학": 3,
-        "학술": 4,
-        "입학": 5,
-        "취업": 6,
-        "사무": 7,
-        "기타": 8,
-        "행사": 166,
-        "파란학기제": 167,
-        "파란학기": 167,
-        "학사일정": 168,
-    }
-
-    __slots__ = ("nums", "category", "keyword")
+    CATEGORIES = CATEGORIES
+
+    __slots__ = ("nums", "category", "keyword", "offset")
 
     def __init__(
         self,
@@ -72,10 +67,12 @@ class NoticeFilter:
         nums: Optional[int] = 15,
         category: Optional[int | str] = None,
         keyword: Optional[str] = "",
+        offset: int = 0,
     ):
         self.nums = nums
         self.category = category
         self.keyword = keyword
+        self.offset = offset  # 건너뛸 공지 수 (쪽 * nums)
 
     def build(self) -> str:
         if self.keyword is None:
@@ -83,7 +80,7 @@ class NoticeFilter:
         if self.category is None:
             self.category = ""
 
-        return f"https://www.ajou.ac.kr/kr/ajou/notice.do?mode=list&srSearchKey=&srSearchVal={quote(self.keyword.strip())}&article.offset=0&srCategoryId={self.category}&articleLimit={self.nums}"
+        return f"https://www.ajou.ac.kr/kr/ajou/notice.do?mode=list&srSearchKey=&srSearchVal={quote(self.keyword.strip())}&article.offset={self.offset}&srCategoryId={self.category}&articleLimit={self.nums}"
 
     def set_number_of_notice(self, num: int) -> None:
         self.nums = num
@@ -101,6 +98,9 @@ class NoticeFilter:
     def set_keyword(self, keyword: str) -> None:
         self.keyword = keyword
 
+    def set_offset(self, offset: int) -> None:
+        self.offset = offset
+
     def __repr__(self) -> str:
         return self.build()
 
@@ -112,6 +112,9 @@ class Ajou:
     Methods
     -------
     run()
+    poll() -> List[Notice] | Error
+    crawl() -> int
+    backfill() -> int
 
     Usage
     -----
@@ -122,10 +125,26 @@ class Ajou:
     ADDRESS = "https://www.ajou.ac.kr/kr/ajou/notice.do"
     LENGTH = 15
 
-    __slots__ = ()
+    flights = SingleFlight()  # 같은 URL 동시 요청은 한 번만 불러온다
+
+    __slots__ = (
+        "etag",
+        "lastModified",
+        "tableHash",
+        "retention",
+        "crawler",
+        "backfiller",
+    )
 
     def __init__(self):
         print("Initializing...")
+        # poll() 이 지난번 응답과 비교할 값
+        self.etag = None
+        self.lastModified = None
+        self.tableHash = None
+        self.retention = RetentionManager()  # 오래된 공지 -> ajou_notices_archive
+        self.crawler = Crawler(self.crawlPage, self.crawlTargets)  # 전체 카테고리
+        self.backfiller = Backfill(self.crawlPage, self.pageUrl)  # 오래된 쪽
 
     def run(self, period=1800):  # period (second)
         """Check notices from html per period"""
@@ -169,29 +188,27 @@ class Ajou:
                     continue  # possible weekend
 
                 print("Trying to parse new posts...")
-                notices = self.parser()  # 다시 파싱
-                while notices is Error:  # 파싱이 안되면 5분마다 다시 시도
-                    time.sleep(300)
-                    notices = self.parser()
-
-                for notice in notices:  # type: ignore
-                    isDuplicated = False
-                    with get_db() as db:
-                        if db_model.crud.get_notice_by_id(db=db, notice_id=notice.id):
-                            isDuplicated = True
-                    if isDuplicated:
-                        continue
-
-                    with get_db() as db:
-                        db_model.crud.create_notice(
-                            db=db,
-                            id=notice.id,
-                            title=notice.title,
-                            category=notice.category,
-                            date=notice.date,
-                            link=notice.link,
-                            writer=notice.writer,
-                        )
+                notices = self.poll()  # 바뀐 게 없으면 파싱/DB 모두 건너뛴다
+                while notices in (Error.TIMEOUT, Error.INVALID_URL):
+                    time.sleep(300)  # 파싱이 안되면 5분마다 다시 시도
+                    notices = self.poll()
+
+                if notices is Error.NOT_MODIFIED:
+                    print("Nothing changed since the last poll.")
+                if isinstance(notices, Error):
+                    notices = []
+
+                with get_db() as db:  # 조회 1번 + insert 1번, 한 트랜잭션
+                    created = db_model.crud.create_notices(db=db, notices=notices)
+                print(f"{created} new notices")
+
+                if self.crawler.maybe_run():  # interval 마다 모든 카테고리
+                    print("Crawl:", self.crawler.stats())
+                if self.backfiller.maybe_run():
+                    print("Backfill:", self.backfiller.stats())
+
+                if self.retention.maybe_run():  # interval 이 지났을 때만 실제로 돈다
+                    print("Retention:", self.retention.stats())
 
                 print("Parsed at", self.getTimeNow())
                 print(f"Resting 30 minute...")
@@ -219,40 +236,121 @@ class Ajou:
             url = url
         else:
             url = filter.build()
-        context = ssl._create_unverified_context()
+
+        return self.flights.do(url, lambda: self._parse(url))
+
+    def _parse(self, url: str) -> List[Notice] | Error:
         try:
-            result = urlopen(url, timeout=3.0, context=context)
-        except HTTPError:
-            # print("Seems like the server is down now.")
+            result = fetch(url, timeout=3.0)
+        except (URLError, OSError) as e:  # HTTPError, TimeoutError 도 여기로
+            return self.fetchError(e)
+
+        return self.parseHTML(result.body)
+
+    @staticmethod
+    def fetchError(e: OSError) -> Error:
+        """fetch 가 던진 예외 -> Error (run() 루프가 끝나지 않도록)"""
+        if isinstance(e, HTTPError):  # Seems like the server is down now.
             return Error.INVALID_URL
-        except TimeoutError:
-            # print("It's taking too long to load website.")
+        if isinstance(e, TimeoutError) or (
+            isinstance(e, URLError) and isinstance(e.reason, TimeoutError)
+        ):  # It's taking too long to load website.
             return Error.TIMEOUT
+        if isinstance(
+            e, URLError
+        ):  # DNS, 연결 거부, TLS (http_pool 이 URLError 로 감싼다)
+            return Error.INVALID_URL
+        return Error.TIMEOUT  # 연결이 끊겼다
+
+    def crawl(self) -> int:
+        """모든 카테고리의 처음 몇 쪽을 병렬로 불러와서 저장한다. 새 공지 수"""
+        return self.crawler.run()
+
+    def backfill(self) -> int:
+        """checkpoint 부터 오래된 쪽을 읽어서 저장한다. 새 공지 수"""
+        return self.backfiller.run()
+
+    @staticmethod
+    def pageUrl(offset: int, limit: int) -> str:
+        return NoticeFilter(nums=limit, offset=offset).build()
+
+    def crawlTargets(self, pages: int) -> List[str]:
+        """카테고리마다 pages 쪽 (같은 id 인 파란학기/파란학기제는 한 번)"""
+        return [
+            NoticeFilter(
+                nums=self.LENGTH, category=category, offset=page * self.LENGTH
+            ).build()
+            for category in CATEGORY_IDS
+            for page in range(pages)
+        ]
+
+    def crawlPage(self, url: str) -> List[Notice] | Error:
+        """Crawler 용 parser(). 공지가 없는 쪽은 실패가 아니라 []"""
+        notices = self.parser(url)
+        return [] if notices is Error.NO_NOTICE else notices
+
+    def poll(self, url: Optional[str] = None) -> List[Notice] | Error:
+        """
+        parser() 와 같지만 지난번과 같으면 Error.NOT_MODIFIED 를 돌려준다.
+        1) If-None-Match / If-Modified-Since 로 304 를 받거나
+        2) 공지 테이블 부분의 hash 가 같으면 파싱하지 않는다.
+        """
+        if url is None:
+            url = NoticeFilter().build()
+
+        headers = {}
+        if self.etag:
+            headers["If-None-Match"] = self.etag
+        if self.lastModified:
+            headers["If-Modified-Since"] = self.lastModified
+
+        try:
+            result = fetch(url, timeout=3.0, headers=headers)
+        except (URLError, OSError) as e:  # HTTPError, TimeoutError 도 여기로
+            return self.fetchError(e)
+
+        if result.status == 304:
+            return Error.NOT_MODIFIED
+
+        digest = self.hashTable(result.body)
+        if digest == self.tableHash:
+            self.remember(result, digest)
+            return Error.NOT_MODIFIED
+
+        notices = self.parseHTML(result.body)
+        if not isinstance(notices, Error):
+            # 파싱에 실패했으면 validator 도 남기지 않는다 (304 로 다시 못 보게 된다)
+            self.remember(result, digest)
+        return notices
+
+    def remember(self, result, digest: bytes) -> None:
+        """다음 poll 의 If-None-Match / If-Modified-Since 와 table hash"""
+        self.etag = result.headers.get("ETag")
+        self.lastModified = result.headers.get("Last-Modified")
+        self.tableHash = digest
 
-        html = result.read().decode("utf-8")
-        soup = HTMLParser(html)
-        no_post = soup.css("td.b-no-post")
-        if no_post:
+    @staticmethod
+    def hashTable(html: bytes) -> bytes:
+        """공지 목록(tbody) 부분만 hash. 페이지의 나머지(배너, 토큰 등)는 무시한다."""
+        start = html.find(b"<tbody")
+        end = html.find(b"</tbody>", start)
+        if start < 0 or end < 0:
+            start, end = 0, len(html)
+        return hashlib.blake2b(html[start:end], digest_size=16).digest()
+
+    def parseHTML(self, html: bytes) -> List[Notice] | Error:
+        rows = scan_notices(html)
+        if not rows:
             return Error.NO_NOTICE
 
         notices: List[Notice] = []
 
-        ids = soup.css("td.b-num-box")
-        posts = soup.css("div.b-title-box > a")
-        cates = soup.css("span.b-cate")
-        dates = soup.css("span.b-date")
-        writers = soup.css("span.b-writer")
-
-        for i in range(len(ids)):
-            id = ids[i].text(strip=True)
+        for id, title, posted, writer, href, category in rows:
             try:
                 id = int(id)
             except Exception:  # 공지
                 continue
-
-            title = posts[i].text(strip=True)
-            writer = writers[i].text(strip=False)
-            category = cates[i].text(strip=True)
+            day = to_day(posted)  # "21.03.01" -> date, 한 번만 바꾼다
 
             duplicate = "[" + writer + "]"
             if duplicate in title:  # writer: [writer] title
@@ -261,10 +359,10 @@ class Ajou:
             if duplicate in title:  # writer: [writer] title
                 title = title.replace(duplicate, "").strip()  # -> writer: title
 
-            date = dates[i].text(strip=True)
-            link = self.ADDRESS + str(posts[i].attributes["href"])
+            link = self.ADDRESS + href
 
-            notices.append(Notice(id, title, category, writer, date, link))
+            posted = date.fromordinal(day) if day else None
+            notices.append(Notice(id, title, category, writer, posted, link))
 
         if not notices:
             return Error.NO_NOTICE
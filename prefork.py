@@ -0,0 +1,271 @@
+"""pre-fork 워커 모드
+
+supervisor (부모) 는 스레드 없이 fork 와 wait 만 한다.
+    publisher 1개  app 의 startup (health probe, ingest, 유저 레지스트리) 을 돌리고
+                   refresh 초마다 응답 표와 read model 을 공유 mmap 에 쓴다.
+                   (ajou_native.snapshot_write)
+    worker N개     SO_REUSEPORT 로 같은 포트를 열고, 응답 표와 read model 은 공유 mmap
+                   에서 lock 없이 읽는다. (snapshot_read) 새 유저 id 는 pipe 로
+                   publisher 에 넘긴다.
+죽은 자식은 다시 띄우고, SIGINT/SIGTERM 이면 자식에게 SIGTERM 을 보내고 기다린다.
+
+홈페이지 fetch 와 학사일정/어제 공지 조회는 publisher 만 하므로 워커를 늘려도
+업스트림 요청은 늘지 않는다. (/search 는 워커마다 notice cache)
+native 가 아니면 워커는 uvicorn 으로 뜨고, read model 만 스레드에서 읽어 온다.
+ajou_native 가 없으면 (공유 mmap 을 못 쓴다) 워커마다 read model 을 직접 불러온다.
+
+Usage
+-----
+    Supervisor(application, nativeTable, userRegistry, 4, model=readModel).run()
+
+환경 변수
+    KAKAO_WORKERS   워커 수 (default 0 = supervisor 없이 한 프로세스)
+    KAKAO_SHM_SIZE  공유 응답 표 크기(byte) (default 8MB)
+    KAKAO_SHM_POLL  워커가 표가 바뀌었는지 보는 주기(초) (default 0.2)
+"""
+
+import asyncio
+import marshal
+import mmap
+import os
+import select
+import signal
+import socket
+import sys
+import threading
+import time
+
+import uvicorn
+
+from native_server import NATIVE_REFRESH, Lifespan, NativeFrontend, encodeTable
+
+try:
+    from ajou_native import snapshot_read, snapshot_reset, snapshot_write
+except ImportError:  # not built, or not Linux
+    snapshot_read = snapshot_reset = snapshot_write = None
+
+WORKERS = int(os.environ.get("KAKAO_WORKERS", 0))
+SHM_SIZE = int(os.environ.get("KAKAO_SHM_SIZE", 8 * 1024 * 1024))
+SHM_POLL = float(os.environ.get("KAKAO_SHM_POLL", 0.2))
+RESPAWN_DELAY = 1.0  # 자식이 바로 죽는 경우 fork 를 반복하지 않도록
+
+role = None  # fork 된 자식: "publisher" | "worker"
+
+
+def inWorker():
+    return role == "worker"
+
+
+def sharesModel():
+    """read model 을 publisher 의 snapshot 에서 읽는 워커인가"""
+    return inWorker() and snapshot_read is not None
+
+
+class Supervisor:
+    """
+    Methods
+    -------
+    run(host, port)
+    """
+
+    __slots__ = (
+        "app",
+        "build",
+        "registry",
+        "workers",
+        "native",
+        "refresh",
+        "model",
+        "_host",
+        "_shm",
+        "_seq",
+        "_users",
+        "_partial",
+        "_children",
+        "_stopping",
+    )
+
+    def __init__(
+        self,
+        app,
+        build,
+        registry,
+        workers=WORKERS,
+        native=True,
+        refresh=NATIVE_REFRESH,
+        model=None,
+    ):
+        self.app = app
+        self.build = build  # async () -> {key: (bodies, track)}
+        self.registry = registry  # UserRegistry
+        self.workers = workers
+        self.native = bool(native and NativeFrontend.available() and snapshot_read)
+        self.refresh = refresh
+        self.model = model  # ReadModel (publisher 가 export, 워커가 load)
+        self._host = None
+        self._shm = None
+        self._seq = 0  # 워커가 마지막으로 읽은 snapshot
+        self._users = None  # (read, write) pipe
+        self._partial = b""
+        self._children = {}  # pid -> role
+        self._stopping = False
+
+    def run(self, host="0.0.0.0", port=8000):
+        self._host = (host, port)
+        self._shm = mmap.mmap(
+            -1, SHM_SIZE
+        )  # MAP_SHARED | MAP_ANONYMOUS, 자식과 같이 본다
+        self._users = os.pipe()
+        os.set_blocking(self._users[1], False)
+        signal.signal(signal.SIGINT, self._stop)
+        signal.signal(signal.SIGTERM, self._stop)
+
+        self._spawn("publisher")
+        for _ in range(self.workers):
+            self._spawn("worker")
+        mode = "native" if self.native else "uvicorn"
+        print(f"Supervisor: {self.workers} {mode} workers on http://{host}:{port}")
+
+        while self._children:
+            try:
+                pid, status = os.wait()
+            except ChildProcessError:
+                break
+            who = self._children.pop(pid, None)
+            if who is None or self._stopping:
+                continue
+            print(f"{who} {pid} exited ({status}), restarting...")
+            if who == "publisher" and snapshot_reset is not None:
+                snapshot_reset(self._shm)  # 쓰다가 죽었으면 seq 가 홀수로 남아 있다
+            time.sleep(RESPAWN_DELAY)
+            if not self._stopping:
+                self._spawn(who)
+        print("\nExiting...")
+
+    def _stop(self, signum, frame):
+        if self._stopping:
+            return
+        self._stopping = True
+        for pid in list(self._children):
+            try:
+                os.kill(pid, signal.SIGTERM)
+            except ProcessLookupError:
+                pass
+
+    def _spawn(self, who):
+        pid = os.fork()
+        if pid:
+            self._children[pid] = who
+            return
+
+        global role
+        role = who
+        code = 0
+        try:
+            # Ctrl+C 는 supervisor 가 받아서 SIGTERM 으로 (event loop 가 main task 를 취소)
+            signal.signal(signal.SIGINT, signal.SIG_IGN)
+            signal.signal(signal.SIGTERM, signal.SIG_DFL)
+            if who == "publisher":
+                asyncio.run(self._publisher())
+            else:
+                self._worker()
+        except KeyboardInterrupt:
+            pass
+        except BaseException as e:
+            print(f"{who} {os.getpid()} failed: {e}")
+            code = 1
+        finally:
+            sys.stdout.flush()
+            os._exit(code)
+
+    # publisher
+
+    async def _publisher(self):
+        loop = asyncio.get_running_loop()
+        loop.add_signal_handler(signal.SIGTERM, asyncio.current_task().cancel)
+        os.close(self._users[1])
+        lifespan = Lifespan(self.app)
+        await lifespan.startup()
+        loop.add_reader(self._users[0], self._readUsers)
+        last = None  # 마지막으로 쓴 (table, model)
+        try:
+            while True:
+                if snapshot_write is not None:
+                    try:
+                        table = encodeTable(await self.build())
+                        model = self.model.export() if self.model is not None else None
+                        if (
+                            table,
+                            model,
+                        ) != last:  # 같으면 seq 도 그대로 (워커가 다시 읽지 않게)
+                            snapshot_write(self._shm, marshal.dumps((table, model)))
+                            last = (table, model)
+                    except Exception as e:  # 워커는 지난 표를 그대로 쓴다
+                        print(f"Snapshot failed: {e}")
+                await asyncio.sleep(self.refresh)
+        except asyncio.CancelledError:
+            print("Terminated...")
+        finally:
+            loop.remove_reader(self._users[0])
+            await lifespan.shutdown()
+
+    def _readUsers(self):
+        data = self._partial + os.read(self._users[0], 65536)
+        *users, self._partial = data.split(b"\n")
+        for user in users:
+            self.registry.ensure(user.decode("utf-8", "surrogateescape"))
+
+    # worker
+
+    def _sendUser(self, user_id):
+        """한 줄씩 (PIPE_BUF 이하라 워커끼리 섞이지 않는다). 막히면 False"""
+        line = user_id.encode("utf-8", "surrogateescape") + b"\n"
+        if b"\n" in line[:-1] or len(line) > select.PIPE_BUF:
+            return True  # 등록할 수 없는 id
+        try:
+            return os.write(self._users[1], line) == len(line)
+        except BlockingIOError:
+            return False
+
+    def _read(self):
+        """바뀌었으면 read model 을 load 하고 응답 표를 돌려준다."""
+        got = snapshot_read(self._shm, self._seq)
+        if got is None:
+            return None  # 바뀌지 않았다
+        self._seq, payload = got
+        if not payload:  # publisher 가 다시 뜨는 중 (snapshot_reset)
+            return None
+        table, model = marshal.loads(payload)
+        if self.model is not None and model is not None:
+            self.model.load(model)
+        return table
+
+    async def _snapshot(self):
+        return self._read()
+
+    def _reading(self):
+        while True:
+            try:
+                self._read()
+            except Exception as e:  # 지난 목록을 그대로 쓴다
+                print(f"Snapshot read failed: {e}")
+            time.sleep(SHM_POLL)
+
+    def _worker(self):
+        os.close(self._users[0])
+        self.registry.forwardTo(self._sendUser)
+        host, port = self._host
+        if self.native:
+            frontend = NativeFrontend(
+                self.app, self._snapshot, self.registry.ensure, SHM_POLL
+            )
+            frontend.run(host, port, reusePort=True)
+            return
+
+        if snapshot_read is not None and self.model is not None:
+            threading.Thread(target=self._reading, daemon=True).start()
+        sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEPORT, 1)
+        sock.bind((host, port))
+        uvicorn.Server(uvicorn.Config(self.app, log_level="info")).run(sockets=[sock])
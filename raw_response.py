@@ -0,0 +1,47 @@
+"""미리 인코딩된 응답
+
+Prepared 는 body 와 Content-Length 등 헤더를 한 번만 만들어 두고,
+RawResponse 는 render()/init_headers() 없이 그것을 그대로 ASGI 서버에 넘긴다.
+body 는 bytes 라서 복사하지 않고 같은 객체를 계속 보낸다.
+
+Usage
+-----
+    TIMEOUT = Prepared(Ktemplate.buildSimpleText("..."))
+
+    @application.post("/x")
+    async def x():
+        return RawResponse(TIMEOUT)
+"""
+
+from fastapi.responses import Response
+
+
+class Prepared:
+    """완성된 JSON body + raw header 목록"""
+
+    __slots__ = ("body", "headers")
+
+    def __init__(self, body, media_type=b"application/json"):
+        self.body = bytes(body)
+        self.headers = (
+            (b"content-length", str(len(self.body)).encode("latin-1")),
+            (b"content-type", media_type),
+        )
+
+    def __len__(self):
+        return len(self.body)
+
+
+class RawResponse(Response):
+    """Prepared (또는 bytes) 를 그대로 보내는 Response"""
+
+    media_type = "application/json"
+
+    def __init__(self, prepared, status_code=200):
+        if not isinstance(prepared, Prepared):
+            prepared = Prepared(prepared)
+        self.status_code = status_code
+        self.background = None
+        self.body = prepared.body
+        # CORS 같은 middleware 가 헤더를 덧붙이므로 list 만 새로 만든다.
+        self.raw_headers = list(prepared.headers)
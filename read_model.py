@@ -0,0 +1,214 @@
+"""홈페이지 공지 read model
+
+요청 경로에서 홈페이지에 가지 않도록, 백그라운드 ingest 가 최신 목록과 카테고리별
+목록을 주기적으로 불러와 메모리에 둔다. /message (오늘), /last, /ask/filter 는
+여기서만 읽는다. (키워드 검색은 입력이 끝이 없으므로 지금처럼 noticeCache 로)
+
+불러오지 못하면 지난 목록을 그대로 둔다. 홈페이지가 느려도 응답은 바로 나가고,
+한 번도 불러오지 못한 목록만 None (핸들러가 timeout 메시지를 보낸다).
+pre-fork 워커는 직접 불러오지 않고 publisher 가 export() 한 열 배열
+(NoticeBatch.dump()) 을 load() 한다. 다시 불러와도 내용이 같으면 목록을 바꾸지 않아서
+export() 도 그대로다.
+
+환경 변수
+    AJOU_INGEST_LATEST      최신 목록 주기(초) (default 60)
+    AJOU_INGEST_CATEGORIES  카테고리 목록 주기(초) (default 300)
+    AJOU_INGEST_TIMEOUT     목록 하나를 불러오는 timeout(초) (default 10)
+"""
+
+import asyncio
+import os
+import time
+from urllib.error import HTTPError, URLError
+
+from categories import CATEGORY_IDS
+
+INGEST_LATEST = float(os.environ.get("AJOU_INGEST_LATEST", 60.0))
+INGEST_CATEGORIES = float(os.environ.get("AJOU_INGEST_CATEGORIES", 300.0))
+INGEST_TIMEOUT = float(os.environ.get("AJOU_INGEST_TIMEOUT", 10.0))
+
+LATEST = "latest"
+LATEST_LENGTH = 30  # 오늘 공지를 고를 만큼
+CATEGORY_LENGTH = 5  # ListCard 최대
+
+
+class _List:
+    __slots__ = ("notices", "data", "fetched", "plain", "dated")
+
+    def __init__(self, notices, data, fetched):
+        self.notices = notices  # NoticeBatch
+        self.data = data  # notices.dump(), 비교와 export() 용
+        self.fetched = fetched  # time.time(), 내용이 바뀐 때
+        # 카드는 요청마다가 아니라 내용이 바뀔 때 한 번만 만든다
+        self.plain = notices.to_cards()
+        self.dated = notices.to_cards(put_date=True)
+
+
+class ReadModel:
+    """
+    fetch(url, timeout) 는 홈페이지 응답 body 를 돌려주는 coroutine,
+    parse(html) 는 (NoticeBatch, length) | (None, 0) (Homepage.toNotices),
+    restore(data) 는 NoticeBatch.dump() 를 되돌린다 (notice_scan.load_batch)
+
+    Methods
+    -------
+    latest() -> NoticeBatch | None
+    category(id) -> NoticeBatch | None
+    cards(key, putDate=False) -> (NoticeBatch, [card bytes, ...]) | (None, None)
+        key 는 LATEST | id, 같은 목록의 batch 와 카드를 같이 돌려준다
+    refresh(keys) -> int  (await)
+    start()  (await, 첫 최신 목록을 불러온 뒤 ingest 를 띄운다)
+    stop()
+    export() -> dict
+    load(exported) -> int
+    stats() -> dict
+    """
+
+    __slots__ = (
+        "address",
+        "fetch",
+        "parse",
+        "restore",
+        "latestInterval",
+        "categoryInterval",
+        "_lists",
+        "_task",
+        "_checked",
+        "fetches",
+        "failures",
+    )
+
+    def __init__(
+        self,
+        address,
+        fetch,
+        parse,
+        restore,
+        latestInterval=INGEST_LATEST,
+        categoryInterval=INGEST_CATEGORIES,
+    ):
+        self.address = address
+        self.fetch = fetch
+        self.parse = parse
+        self.restore = restore
+        self.latestInterval = latestInterval
+        self.categoryInterval = categoryInterval
+        self._lists = {}  # LATEST | srCategoryId -> _List
+        self._task = None
+        self._checked = {}  # key -> 마지막으로 불러온 time.time() (내용이 같아도)
+        self.fetches = self.failures = 0
+
+    def url(self, key):
+        if key == LATEST:
+            return (
+                f"{self.address}?mode=list"
+                f"&articleLimit={LATEST_LENGTH}&article.offset=0"
+            )
+        return (
+            f"{self.address}?mode=list&srCategoryId={key}&srSearchKey=&srSearchVal="
+            f"&articleLimit={CATEGORY_LENGTH}&article.offset=0"
+        )
+
+    def _get(self, key):
+        entry = self._lists.get(key)
+        return entry.notices if entry is not None else None
+
+    def latest(self):
+        return self._get(LATEST)
+
+    def category(self, id):
+        return self._get(id)
+
+    def cards(self, key, putDate=False):
+        entry = self._lists.get(key)
+        if entry is None:
+            return None, None
+        return entry.notices, (entry.dated if putDate else entry.plain)
+
+    async def refresh(self, keys):
+        """keys 를 하나씩 (홈페이지에 한꺼번에 몰리지 않게) 불러온다. 바뀐 목록 수"""
+        updated = 0
+        for key in keys:
+            self.fetches += 1
+            try:
+                html = await self.fetch(self.url(key), INGEST_TIMEOUT)
+            except (HTTPError, URLError, TimeoutError, OSError) as e:
+                self.failures += 1
+                print(f"Ingest {key} failed: {e!r}")
+                continue
+
+            notices, length = self.parse(html)
+            if length == 0:
+                self.failures += 1  # 빈 목록은 지난 목록보다 나을 게 없다
+                continue
+            self._checked[key] = time.time()
+            data = notices.dump()
+            entry = self._lists.get(key)
+            if entry is not None and entry.data == data:
+                continue  # 그대로면 export() 도 그대로
+            self._lists[key] = _List(notices, data, time.time())
+            updated += 1
+        return updated
+
+    async def start(self):
+        if self._task is not None:
+            return self._task
+        await self._tryRefresh([LATEST])  # 첫 요청부터 오늘/마지막 공지가 있도록
+        self._task = asyncio.ensure_future(self._ingest())
+        return self._task
+
+    def stop(self):
+        if self._task is not None:
+            self._task.cancel()
+            self._task = None
+
+    async def _ingest(self):
+        nextCategories = 0.0
+        while True:
+            if time.monotonic() >= nextCategories:
+                await self._tryRefresh(CATEGORY_IDS)
+                nextCategories = time.monotonic() + self.categoryInterval
+            await asyncio.sleep(self.latestInterval)
+            await self._tryRefresh([LATEST])
+
+    async def _tryRefresh(self, keys):
+        """refresh() 가 던져도 (parse, dump 등) ingest task 는 끝나지 않게"""
+        try:
+            return await self.refresh(keys)
+        except Exception as e:  # 다음 주기에 다시
+            self.failures += 1
+            print(f"Ingest {keys} failed: {e!r}")
+            return 0
+
+    def export(self):
+        """{key: (data, fetched)} (marshal 가능)"""
+        return {key: (entry.data, entry.fetched) for key, entry in self._lists.items()}
+
+    def load(self, exported):
+        """export() 결과로 바꾼다. 바뀐 목록 수"""
+        loaded = 0
+        for key, (data, fetched) in exported.items():
+            entry = self._lists.get(key)
+            if entry is not None and entry.fetched == fetched:
+                continue
+            self._lists[key] = _List(self.restore(data), data, fetched)
+            loaded += 1
+        return loaded
+
+    def stats(self):
+        """age 는 내용이 바뀐 뒤, checked 는 마지막으로 불러온 뒤 지난 초
+        (checked 는 직접 불러오는 프로세스만, pre-fork 워커는 비어 있다)"""
+        now = time.time()
+        return {
+            "lists": len(self._lists),
+            "age": {
+                str(key): round(now - entry.fetched, 1)
+                for key, entry in self._lists.items()
+            },
+            "checked": {
+                str(key): round(now - checked, 1)
+                for key, checked in self._checked.items()
+            },
+            "fetches": self.fetches,
+            "failures": self.failures,
+        }
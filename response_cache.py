@@ -0,0 +1,71 @@
+"""거의 바뀌지 않는 응답의 완성된 bytes 캐시 (/ask, /schedule)
+
+ttl 이 지나면 다시 만든다. (TTL 전용) ajou_sched 는 이 앱이 아니라 관리
+스크립트가 바꾸므로 ORM 이벤트로는 알 수 없고, 바뀐 뒤 ttl 안에 반영된다.
+바로 반영해야 하면 invalidate() 를 부른다.
+
+환경 변수
+    KAKAO_RESPONSE_TTL  (default 300초)
+"""
+
+import os
+import time
+from random import choice
+
+from http_pool import AsyncSingleFlight
+
+RESPONSE_TTL = float(os.environ.get("KAKAO_RESPONSE_TTL", 300.0))
+
+
+class ResponseCache:
+    """
+    loader() 는 응답 bytes (또는 raw_response.Prepared) 의 list 를 돌려준다. (랜덤 이미지 같은 변형 여러 개)
+    aget() 은 그중 하나를 고른다.
+
+    Methods
+    -------
+    aget(loader) -> bytes  (await)
+    abodies(loader) -> list  (await, 변형 전부)
+    invalidate()
+    stats() -> dict
+    """
+
+    __slots__ = (
+        "ttl",
+        "_bodies",
+        "_built",
+        "_stored",
+        "_flights",
+        "hits",
+        "builds",
+    )
+
+    def __init__(self, ttl=RESPONSE_TTL):
+        self.ttl = ttl
+        self._bodies = None
+        self._stored = 0.0
+        self._flights = AsyncSingleFlight()
+        self.hits = self.builds = 0
+
+    async def aget(self, loader):
+        return choice(await self.abodies(loader))
+
+    async def abodies(self, loader):
+        bodies = self._bodies
+        if bodies is not None and time.monotonic() - self._stored < self.ttl:
+            self.hits += 1
+            return bodies
+
+        return await self._flights.do(None, lambda: self._aload(loader))
+
+    async def _aload(self, loader):
+        bodies = await loader()
+        self._bodies, self._stored = bodies, time.monotonic()
+        self.builds += 1
+        return bodies
+
+    def invalidate(self):
+        self._bodies = None
+
+    def stats(self):
+        return {"hits": self.hits, "builds": self.builds}
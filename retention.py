@@ -0,0 +1,108 @@
+"""ajou_notices 보존 정책
+
+/message 어제 공지와 크롤러의 중복 확인은 최근 공지만 보므로, keep_days 보다
+오래된 공지는 ajou_notices_archive (MySQL: ROW_FORMAT=COMPRESSED) 로 옮겨서
+hot 테이블을 작게 유지한다. 크롤러 (Ajou.run) 가 poll 마다 maybe_run() 을 부르고,
+실제로는 interval 마다 한 번만 돈다.
+
+환경 변수
+    AJOU_RETENTION_DAYS      이보다 오래된 공지를 옮긴다 (default 30, 0 이면 끔)
+    AJOU_RETENTION_BATCH     한 트랜잭션에 옮길 공지 수 (default 500)
+    AJOU_RETENTION_INTERVAL  실행 간격(초) (default 86400)
+"""
+
+import os
+import time
+from datetime import date, timedelta
+
+import db_model.crud
+import db_model.database
+
+RETENTION_DAYS = int(os.environ.get("AJOU_RETENTION_DAYS", 30))
+RETENTION_BATCH = int(os.environ.get("AJOU_RETENTION_BATCH", 500))
+RETENTION_INTERVAL = float(os.environ.get("AJOU_RETENTION_INTERVAL", 86400.0))
+
+
+class RetentionManager:
+    """
+    Methods
+    -------
+    maybe_run() -> int
+    run(today=None) -> int
+    stats() -> dict
+    """
+
+    __slots__ = (
+        "keep_days",
+        "batch",
+        "interval",
+        "last_run",
+        "runs",
+        "moved",
+        "last_moved",
+        "last_cutoff",
+        "last_seconds",
+        "failures",
+    )
+
+    def __init__(
+        self,
+        keep_days=RETENTION_DAYS,
+        batch=RETENTION_BATCH,
+        interval=RETENTION_INTERVAL,
+    ):
+        self.keep_days = keep_days
+        self.batch = batch
+        self.interval = interval
+        self.last_run = None  # time.monotonic()
+        self.runs = 0
+        self.moved = 0  # 지금까지 옮긴 공지 수
+        self.last_moved = 0
+        self.last_cutoff = None
+        self.last_seconds = 0.0
+        self.failures = 0
+
+    def maybe_run(self):
+        if self.keep_days <= 0:
+            return 0
+        if (
+            self.last_run is not None
+            and time.monotonic() - self.last_run < self.interval
+        ):
+            return 0
+        return self.run()
+
+    def run(self, today=None):
+        """today - keep_days 보다 오래된 공지를 batch 개씩 옮긴다. 옮긴 수를 돌려준다."""
+        cutoff = (today or date.today()) - timedelta(days=self.keep_days)
+        start = time.perf_counter()
+        moved = 0
+        try:
+            with db_model.database.SessionLocal() as db:
+                while True:
+                    count = db_model.crud.archive_notices_before(db, cutoff, self.batch)
+                    moved += count
+                    if count < self.batch:
+                        break
+        except Exception as e:  # 다음 interval 에 다시 (옮긴 batch 는 이미 commit)
+            self.failures += 1
+            print(f"Retention failed: {e}")
+
+        self.last_run = time.monotonic()
+        self.runs += 1
+        self.moved += moved
+        self.last_moved = moved
+        self.last_cutoff = cutoff
+        self.last_seconds = time.perf_counter() - start
+        return moved
+
+    def stats(self):
+        return {
+            "keep_days": self.keep_days,
+            "runs": self.runs,
+            "moved": self.moved,
+            "last_moved": self.last_moved,
+            "last_cutoff": self.last_cutoff.isoformat() if self.last_cutoff else None,
+            "last_seconds": self.last_seconds,
+            "failures": self.failures,
+        }
@@ -1,4 +1,4 @@
-from distutils.core import setup
+from distutils.core import Extension, setup
 
 from Cython.Build import cythonize
 
@@ -10,4 +10,7 @@ setup(
             language_level=3,
         ),
     )
+    + [
+        Extension("ajou_native", sources=["ajou_native.c"]),
+    ]
 )
@@ -0,0 +1,87 @@
+"""카카오 스킬 요청 디코더
+
+핸들러는 userRequest.user.id, userRequest.utterance, action.params 만 쓴다.
+ajou_native.skim_skill 이 있으면 payload 전체를 dict 로 만들지 않고 이 세 값만
+꺼내고, 없으면 json.loads 후 꺼낸다. 크기 제한을 넘는 body 는 읽기 전에 413.
+
+Usage
+-----
+    @application.post("/message")
+    async def message(skill: SkillRequest = Depends(readSkill)):
+        skill.userId, skill.params["when"], skill.utterance
+
+환경 변수
+    KAKAO_MAX_BODY  요청 body 최대 크기(byte) (default 65536)
+"""
+
+import json
+import os
+
+from fastapi import HTTPException, Request
+
+try:
+    from ajou_native import skim_skill
+except ImportError:  # not built
+    skim_skill = None
+
+MAX_BODY = int(os.environ.get("KAKAO_MAX_BODY", 64 * 1024))
+
+
+class SkillRequest:
+    __slots__ = ("userId", "params", "utterance")
+
+    def __init__(self, userId=None, params=None, utterance=None):
+        self.userId = userId
+        self.params = params if params is not None else {}
+        self.utterance = utterance
+
+    def __repr__(self) -> str:
+        return f"<SkillRequest {self.userId} {self.params} {self.utterance!r}>"
+
+
+def _get(obj, key):
+    return obj.get(key) if isinstance(obj, dict) else None
+
+
+def _str(value):
+    return value if isinstance(value, str) else None
+
+
+def decode(body):
+    """body (bytes) -> SkillRequest. JSON 이 아니면 ValueError, 너무 깊으면 RecursionError"""
+    if skim_skill is not None:
+        skimmed = skim_skill(body)
+        if skimmed is not None:
+            return SkillRequest(*skimmed)
+
+    content = json.loads(body)  # params 에 문자열이 아닌 값이 있는 경우
+    if not isinstance(content, dict):
+        raise ValueError("skill payload must be an object")
+    user = _get(content.get("userRequest"), "user")
+    params = _get(content.get("action"), "params")
+    return SkillRequest(
+        _str(_get(user, "id")),
+        params if isinstance(params, dict) else {},
+        _str(_get(content.get("userRequest"), "utterance")),
+    )
+
+
+async def readSkill(request: Request):
+    """FastAPI dependency. Content-Length 가 크면 body 를 받기 전에 거절한다."""
+    length = request.headers.get("content-length")
+    if length is not None:
+        if not length.isdigit():
+            raise HTTPException(status_code=400, detail="invalid content-length")
+        if int(length) > MAX_BODY:
+            raise HTTPException(status_code=413, detail="payload too large")
+
+    body = bytearray()
+    async for chunk in request.stream():  # chunked 요청
+        body += chunk
+        if len(body) > MAX_BODY:
+            raise HTTPException(status_code=413, detail="payload too large")
+
+    try:
+        return decode(body)
+    except (ValueError, RecursionError):  # [[[...]]] 처럼 깊게 중첩된 body
+        raise HTTPException(status_code=400, detail="invalid skill payload")
@@ -0,0 +1,71 @@
+import os
+from dataclasses import dataclass
+from datetime import date
+
+os.environ.setdefault("KAKAO_DB", "sqlite://")  # backfill 이 db_model 을 import 한다
+
+import db_model.crud
+import db_model.database
+import db_model.models
+from backfill import Backfill
+
+
+@dataclass
+class Notice:
+    id: int
+    title: str = "t"
+    category: str = "학사"
+    date: date = date(2021, 3, 1)
+    link: str = "https://l"
+    writer: str = "w"
+
+
+def test_backfill_resumes_then_stops_at_stored():
+    db_model.models.Base.metadata.create_all(bind=db_model.database.engine)
+    site = list(range(50, 0, -1))  # 최신 id 부터
+    urls = []
+
+    def parse(url):
+        offset, limit = url
+        urls.append(url)
+        return [Notice(id) for id in site[offset : offset + limit]]
+
+    backfill = Backfill(
+        parse, lambda offset, limit: (offset, limit), "test", stride=10, pages=3, step=2
+    )
+    assert backfill.run() == 30
+    assert (backfill.offset, backfill.complete) == (30, False)
+
+    assert backfill.run() == 20, "resumes from the checkpoint"
+    assert (backfill.offset, backfill.complete) == (0, True)
+
+    site[:0] = range(55, 50, -1)
+    urls.clear()
+    assert backfill.run() == 5
+    assert urls == [(0, 2), (2, 4)], "small pages until a stored id"
+
+
+def test_backfill_fills_gap_below_newer_stored_rows():
+    db_model.models.Base.metadata.create_all(bind=db_model.database.engine)
+    site = list(range(150, 100, -1))
+
+    def parse(url):
+        offset, limit = url
+        return [Notice(id) for id in site[offset : offset + limit]]
+
+    backfill = Backfill(
+        parse, lambda offset, limit: (offset, limit), "gap", stride=50, pages=5, step=2
+    )
+    assert backfill.run() == 50
+    assert backfill.complete
+
+    site[:0] = range(170, 150, -1)  # 멈춰 있던 사이에 20개
+    with db_model.database.SessionLocal() as db:  # poll / crawler 가 위쪽을 먼저 저장
+        db_model.crud.create_notices(db=db, notices=[Notice(id) for id in site[:15]])
+
+    assert backfill.run() == 5, "walks past the newer stored rows down to the last run"
+    with db_model.database.SessionLocal() as db:
+        assert db_model.crud.stored_notice_ids(db, range(151, 171)) == set(
+            range(151, 171)
+        )
+        assert db_model.crud.get_checkpoint(db, "gap").newest_id == 170
@@ -0,0 +1,91 @@
+import asyncio
+import gc
+import threading
+import time
+
+from notice_cache import NoticeCache
+
+
+def test_cache_ttl():
+    calls = []
+    cache = NoticeCache(ttl=60, stale=0)
+    loader = lambda: calls.append(1) or len(calls)
+
+    assert cache.get("url", loader) == 1
+    assert cache.get("url", loader) == 1, "fresh entry should not reload"
+    cache.invalidate("url")
+    assert cache.get("url", loader) == 2
+
+
+def test_cache_failure_not_stored():
+    cache = NoticeCache(ttl=60)
+    assert cache.get("url", lambda: None) is None
+    assert cache.get("url", lambda: "ok") == "ok"
+
+
+def test_cache_single_flight():
+    calls = []
+    gate = threading.Event()
+    cache = NoticeCache(ttl=60)
+
+    def loader():
+        calls.append(1)
+        gate.wait(1.0)
+        return "notices"
+
+    results = []
+    threads = [
+        threading.Thread(target=lambda: results.append(cache.get("url", loader)))
+        for _ in range(10)
+    ]
+    for t in threads:
+        t.start()
+    time.sleep(0.05)
+    gate.set()
+    for t in threads:
+        t.join()
+
+    assert len(calls) == 1, f"Check single flight: {len(calls)} loads"
+    assert results == ["notices"] * 10
+
+
+def test_cache_stale_while_revalidate():
+    cache = NoticeCache(ttl=0.01, stale=60)
+    assert cache.get("url", lambda: "old") == "old"
+    time.sleep(0.02)
+
+    refreshed = threading.Event()
+
+    def loader():
+        refreshed.set()
+        return "new"
+
+    assert cache.get("url", loader) == "old", "stale entry is served immediately"
+    assert refreshed.wait(1.0)
+    time.sleep(0.01)
+    assert cache.get("url", loader) == "new"
+
+
+def test_cache_async_refresh_is_kept():
+    cache = NoticeCache(ttl=0.01, stale=60)
+
+    async def old():
+        return "old"
+
+    async def new():
+        await asyncio.sleep(0.01)
+        return "new"
+
+    async def main():
+        assert await cache.aget("url", old) == "old"
+        await asyncio.sleep(0.02)
+        assert (
+            await cache.aget("url", new) == "old"
+        ), "stale entry is served immediately"
+        assert len(cache._tasks) == 1
+        gc.collect()  # loop 는 task 를 weakref 로만 들고 있다
+        await asyncio.sleep(0.05)
+        assert not cache._tasks
+        return await cache.aget("url", new)
+
+    assert asyncio.run(main()) == "new"
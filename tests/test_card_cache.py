@@ -0,0 +1,16 @@
+from card_cache import CardCache
+from json_model import Ktemplate
+
+
+def test_card_cache_reuses_and_rebuilds():
+    cache = CardCache()
+    args = ("1", "title", "21.03.01", "https://l", "학사팀")
+
+    assert cache.card(*args) == Ktemplate.buildCard(*args)
+    assert cache.card(*args, True) == Ktemplate.buildCard(*args, True)
+    assert cache.card(1, *args[1:]) is cache.card(*args), "DB int id shares the entry"
+    assert cache.stats()["builds"] == 1
+
+    edited = ("1", "title (수정)", "21.03.01", "https://l", "학사팀")
+    assert cache.card(*edited) == Ktemplate.buildCard(*edited)
+    assert cache.stats()["changed"] == 1
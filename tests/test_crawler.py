@@ -0,0 +1,58 @@
+import os
+import threading
+import time
+from dataclasses import dataclass
+
+os.environ.setdefault("KAKAO_DB", "sqlite://")  # crawler 가 db_model 을 import 한다
+
+from categories import CATEGORY_IDS
+from crawler import Crawler, HostLimiter
+from http_pool import get_pool
+
+
+@dataclass
+class Notice:
+    id: int
+
+
+def test_crawler_merges_in_parallel():
+    def targets(pages):
+        return [f"https://h/?c={c}&p={p}" for c in CATEGORY_IDS for p in range(pages)]
+
+    def parse(url):
+        time.sleep(0.2)
+        if url.endswith("c=3&p=0"):
+            return None  # 실패한 쪽
+        return [Notice(1), Notice(int(url[-1]) + 10)]
+
+    limiter = HostLimiter(len(CATEGORY_IDS), 0)
+    crawler = Crawler(parse, targets, pages=1, limiter=limiter)
+    start = time.perf_counter()
+    notices = crawler.crawl()
+
+    assert time.perf_counter() - start < 0.4, "about one page load, not eleven"
+    assert [notice.id for notice in notices] == [10, 1], "deduplicated by id"
+    assert crawler.failures == 1
+    assert get_pool("h").size >= len(CATEGORY_IDS), "pool grown to the per-host limit"
+    assert HostLimiter().limit <= 4, "polite by default"
+
+
+def test_host_limiter_bounds_concurrency():
+    limiter = HostLimiter(limit=2, gap=0.01)
+    running, peak, lock = [0], [0], threading.Lock()
+
+    def work():
+        with limiter.slot("h"):
+            with lock:
+                running[0] += 1
+                peak[0] = max(peak[0], running[0])
+            time.sleep(0.05)
+            with lock:
+                running[0] -= 1
+
+    threads = [threading.Thread(target=work) for _ in range(6)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    assert peak[0] == 2
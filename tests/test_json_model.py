@@ -0,0 +1,65 @@
+import json
+
+from json_model import Kjson, Ktemplate
+
+
+def dumps(data):
+    # starlette JSONResponse 와 같은 설정
+    return json.dumps(data, ensure_ascii=False, separators=(",", ":")).encode("utf-8")
+
+
+# Test #1
+def test_list_card_template():
+    title = '[학사팀] "수강신청" 안내 \\ 2021학년도 1학기 정정 기간 및 유의사항 공지'
+
+    expected = Kjson.buildListCard(
+        title="학사 공지",
+        items=[
+            Kjson.buildCard("1", title, "21.03.01", "https://l?a=1&b=2", "학사팀", True)
+        ],
+        buttons=[
+            {"label": "공유하기", "action": "share"},
+            {"label": "학사", "action": "webLink", "webLinkUrl": "https://u"},
+        ],
+        quickReplies=[
+            {"messageText": "어제 공지 보여줘", "action": "message", "label": "어제"}
+        ],
+    )
+    body = Ktemplate.buildListCard(
+        title="학사 공지",
+        items=[
+            Ktemplate.buildCard(
+                "1", title, "21.03.01", "https://l?a=1&b=2", "학사팀", True
+            )
+        ],
+        buttons=[Ktemplate.SHARE, Ktemplate.buildWebLinkButton("학사", "https://u")],
+        quickReplies=[Ktemplate.buildQuickReply("어제", "어제 공지 보여줘")],
+    )
+    assert body == dumps(expected)
+
+
+def test_simple_text_template():
+    assert Ktemplate.buildSimpleText("줄\n바꿈") == dumps(
+        Kjson.buildSimpleText("줄\n바꿈")
+    )
+
+    replies = [{"messageText": "학사", "action": "message", "label": "학사"}]
+    assert Ktemplate.buildSimpleText("?", [Ktemplate.buildQuickReply("학사")]) == dumps(
+        Kjson.buildSimpleText("?", replies)
+    )
+
+
+def test_carousel_template():
+    body = Ktemplate.buildCarousel(
+        [Ktemplate.buildBasicCard("개강", "03.02 ~ 03.02", "https://i")]
+    )
+    assert json.loads(body)["template"]["outputs"][0]["carousel"] == {
+        "type": "basicCard",
+        "items": [
+            {
+                "title": "개강",
+                "description": "03.02 ~ 03.02",
+                "thumbnail": {"imageUrl": "https://i"},
+            }
+        ],
+    }
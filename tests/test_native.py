@@ -0,0 +1,268 @@
+import json
+from datetime import date
+
+from notice_scan import scan_notices
+
+""" notice.do 목록 구조 (일반 글 1개 + 상단 고정 공지 1개)
+
+script 안의 가짜 태그와 주석 처리된 행은 무시되어야 한다.
+"""
+SAMPLE = """<!DOCTYPE html>
+<html><head><script>var a = "<td class='b-num-box'>x</td>";</script></head><body>
+<table class="board-table"><thead><tr><th>번호</th></tr></thead><tbody>
+<tr class="b-top-box">
+  <td class="b-num-box num-notice">
+    공지
+  </td>
+  <td class="b-td-left">
+    <div class="b-title-box">
+      <span class="b-cate">학사</span>
+      <a href="?mode=view&amp;articleNo=111&amp;article.offset=0&amp;articleLimit=3" title="[학사팀] 수강신청 안내 자세히 보기">
+        [학사팀] 수강신청 &lt;필독&gt; 안내
+      </a>
+      <div class="b-m-con">
+        <span class="b-writer">학사팀</span>
+        <span class="b-date">21.03.02</span>
+      </div>
+    </div>
+  </td>
+</tr>
+<!-- <td class="b-num-box">999</td> -->
+<tr>
+  <td class="b-num-box">
+    12345
+  </td>
+  <td class="b-td-left">
+    <div class="b-title-box">
+      <span class="b-cate">장학</span>
+      <a href="?mode=view&amp;articleNo=222" title="장학금 자세히 보기">
+        2021학년도 &#39;교내&#x27; 장학금 <b>선발</b> 공고
+      </a>
+      <div class="b-m-con">
+        <span class="b-writer">장학팀</span>
+        <span class="b-date">21.03.01</span>
+      </div>
+    </div>
+  </td>
+</tr>
+</tbody></table></body></html>
+"""
+
+
+# Test #1
+def test_scan_notices():
+    rows = scan_notices(SAMPLE.encode("utf-8"))
+    assert len(rows) == 2, f"Check your scanner: {len(rows)}"
+
+    id, title, date, writer, href, category = rows[0]
+    assert id == "공지"
+    assert title == "[학사팀] 수강신청 <필독> 안내"
+    assert date == "21.03.02"
+    assert writer == "학사팀"
+    assert href == "?mode=view&articleNo=111&article.offset=0&articleLimit=3"
+    assert category == "학사"
+
+    id, title, date, writer, href, category = rows[1]
+    assert id == "12345"
+    assert title == "2021학년도 '교내' 장학금선발공고"  # text(strip=True) 규칙
+    assert date == "21.03.01"
+    assert writer == "장학팀"
+    assert href == "?mode=view&articleNo=222"
+    assert category == "장학"
+
+
+def test_scan_no_post():
+    html = '<table><tr><td class="b-no-post">등록된 글이 없습니다.</td></tr></table>'
+    assert scan_notices(html.encode("utf-8")) == []
+
+
+def test_card_field_limits():
+    from json_model import Ktemplate
+
+    title = '[학사팀] 2021학년도 1학기 수강신청 정정 기간 및 "유의사항" 안내드립니다 꼭 확인'
+    card = json.loads(
+        Ktemplate.buildCard("1", title, "21.03.01", "https://l", "학사팀", True)
+    )
+
+    assert not card["title"].startswith("[학사팀]")
+    assert len(card["title"]) == 35 and card["title"].endswith(".."), card["title"]
+    assert card["description"] == "학사팀 03.01"
+    assert card["link"] == {"web": "https://l"}
+
+    card = json.loads(
+        Ktemplate.buildCard("1", "t", "21.03.01", "l", "학사팀 교육과정 담당자", True)
+    )
+    assert len(card["description"]) == 16 and card["description"].endswith("..")
+
+
+def test_skill_decode():
+    import skill_request
+
+    payload = {
+        "bot": {"id": "b", "name": "아주대"},
+        "intent": {"id": "i", "extra": {"reason": {"code": 1}}},
+        "userRequest": {
+            "user": {"id": 'u"1', "type": "botUserKey", "properties": {}},
+            "utterance": "오늘 공지\n보여줘",
+            "block": {"id": "x"},
+        },
+        "contexts": [],
+        "action": {"params": {"when": "today", "키": "한"}, "detailParams": {}},
+    }
+    body = json.dumps(payload).encode("utf-8")
+
+    skill = skill_request.decode(body)
+    assert skill.userId == 'u"1'
+    assert skill.params == {"when": "today", "키": "한"}
+    assert skill.utterance == "오늘 공지\n보여줘"
+
+    payload["action"]["params"]["n"] = 3  # 문자열이 아니면 json.loads 로
+    assert skill_request.decode(json.dumps(payload).encode()).params["n"] == 3
+
+
+def test_skill_rejects_deep_nesting():
+    import asyncio
+
+    import pytest
+    from fastapi import HTTPException
+
+    import skill_request
+
+    body = b'{"action":{"params":{"n":' + b"[" * 10000 + b"]" * 10000 + b"}}}"
+
+    class Request:
+        headers = {}
+
+        async def stream(self):
+            yield body
+
+    with pytest.raises(HTTPException) as error:
+        asyncio.run(skill_request.readSkill(Request()))
+    assert error.value.status_code == 400
+
+
+def test_scan_batch():
+    from json_model import Ktemplate
+    from notice_scan import load_batch, scan_batch, to_day
+
+    batch = scan_batch(
+        SAMPLE.encode("utf-8"), "https://www.ajou.ac.kr/kr/ajou/notice.do"
+    )
+    rows = scan_notices(SAMPLE.encode("utf-8"))
+
+    assert len(batch) == len(rows)
+    for i, (id, title, posted, writer, href, _) in enumerate(rows):
+        assert batch.id(i) == (int(id) if id.isdigit() else 0)
+        assert batch.date(i) == posted and batch.writer(i) == writer
+        assert batch.day(i) == to_day(posted)
+        assert batch.link(i).endswith(href)
+        assert not batch.title(i).startswith("[" + writer + "]")
+    assert batch.to_cards(put_date=True) == [
+        Ktemplate.buildCard(*batch.row(i), True) for i in range(len(batch))
+    ]
+    assert batch.leading(batch.day(0)) >= 1
+
+    copy = load_batch(batch.dump())
+    assert [copy.row(i) for i in range(len(copy))] == [
+        batch.row(i) for i in range(len(batch))
+    ]
+    assert copy.to_cards() == batch.to_cards()
+    assert len(load_batch(scan_batch(b"", "").dump())) == 0
+    assert to_day("21.03.01") == date(2021, 3, 1).toordinal()
+    assert to_day("21.02.30") == to_day("공지") == 0
+
+
+def test_native_server():
+    import socket
+    import threading
+
+    import pytest
+
+    ajou_native = pytest.importorskip("ajou_native")
+    if not hasattr(ajou_native, "Server"):
+        pytest.skip("Linux only")
+
+    with socket.socket() as probe:  # 빈 포트
+        probe.bind(("127.0.0.1", 0))
+        port = probe.getsockname()[1]
+    server = ajou_native.Server("127.0.0.1", port)
+    server.publish({"/message?when=today": ([b'{"t":1}'], True)})
+    thread = threading.Thread(target=server.serve_forever, daemon=True)
+    thread.start()
+
+    def post(path, params):
+        body = json.dumps(
+            {"userRequest": {"user": {"id": "u1"}}, "action": {"params": params}}
+        ).encode()
+        return b"POST %s HTTP/1.1\r\ncontent-length: %d\r\n\r\n%s" % (
+            path,
+            len(body),
+            body,
+        )
+
+    with socket.create_connection(("127.0.0.1", port)) as conn:
+        # 발행된 응답, Python 으로 넘어가는 요청이 순서대로 (pipelining)
+        conn.sendall(
+            post(b"/message", {"when": "today"}) + post(b"/search", {"sys_text": "a"})
+        )
+        token, (method, target, headers), body = server.next(5.0)
+        assert (method, target) == ("POST", b"/search")
+        assert json.loads(body)["action"]["params"] == {"sys_text": "a"}
+        server.reply(token, b"HTTP/1.1 200 OK\r\ncontent-length: 2\r\n\r\n{}")
+
+        expected = b'{"t":1}' + b"HTTP/1.1 200 OK\r\ncontent-length: 2\r\n\r\n{}"
+        received = b""
+        while not received.endswith(expected):
+            received += conn.recv(4096)
+    assert received.startswith(b"HTTP/1.1 200 OK\r\n")
+    assert server.drain_users() == ["u1"]
+    assert server.stats()["native"] == server.stats()["fallback"] == 1
+
+    with socket.create_connection(("127.0.0.1", port)) as conn:
+        # HTTP/1.0 keep-alive 는 응답에 그 헤더가 있어야 클라이언트가 다음 요청을 보낸다
+        request = post(b"/message", {"when": "today"}).replace(b"HTTP/1.1", b"HTTP/1.0")
+        request = request.replace(b"\r\n", b"\r\nconnection: keep-alive\r\n", 1)
+        for _ in range(2):
+            conn.sendall(request)
+            received = b""
+            while not received.endswith(b'{"t":1}'):
+                received += conn.recv(4096)
+            assert b"\r\nconnection: keep-alive\r\n" in received
+
+        conn.sendall(request.replace(b"/message", b"/search"))
+        token, _, _ = server.next(None)
+        server.reply(token, b"HTTP/1.1 200 OK\r\ncontent-length: 2\r\n\r\n{}")
+        received = b""
+        while not received.endswith(b"{}"):
+            received += conn.recv(4096)
+        assert b"\r\nconnection: keep-alive\r\n" in received
+
+    server.stop()
+    thread.join()
+
+
+def test_snapshot():
+    import mmap
+
+    import pytest
+
+    ajou_native = pytest.importorskip("ajou_native")
+    if not hasattr(ajou_native, "snapshot_read"):
+        pytest.skip("Linux only")
+
+    shm = mmap.mmap(-1, 64)
+    assert ajou_native.snapshot_read(shm) is None  # 아직 안 썼다
+    seq = ajou_native.snapshot_write(shm, b"table")
+    assert ajou_native.snapshot_read(shm) == (seq, b"table")
+    assert ajou_native.snapshot_read(shm, seq) is None  # 그대로
+    with pytest.raises(ValueError):
+        ajou_native.snapshot_write(shm, b"x" * 64)
+
+    shm[:8] = (seq + 1).to_bytes(8, "little")  # writer 가 쓰다가 죽었다
+    assert ajou_native.snapshot_read(shm, seq) is None, "gives up instead of spinning"
+    reset = ajou_native.snapshot_reset(shm)
+    assert reset % 2 == 0 and ajou_native.snapshot_read(shm, seq) == (reset, b"")
+    assert ajou_native.snapshot_write(shm, b"next") % 2 == 0
+    assert ajou_native.snapshot_read(shm, reset)[1] == b"next"
+    shm[:8] = (reset + 3).to_bytes(8, "little")  # reset 없이 다시 써도 짝수로 끝난다
+    assert ajou_native.snapshot_write(shm, b"again") == reset + 6
@@ -0,0 +1,90 @@
+import asyncio
+from urllib.error import URLError
+
+from read_model import LATEST, ReadModel
+
+
+class Notices(list):
+    def dump(self):
+        return ",".join(self).encode()
+
+    def to_cards(self, put_date=False):
+        return [f"{notice}{'@' if put_date else ''}".encode() for notice in self]
+
+
+def parse(html):
+    notices = Notices(html.decode().split(",")) if html else []
+    return (notices, len(notices)) if notices else (None, 0)
+
+
+def restore(data):
+    return Notices(data.decode().split(","))
+
+
+def test_read_model_keeps_last_list():
+    pages = [b"a,b", URLError("down"), b"", b"c"]
+
+    async def fetch(url, timeout):
+        page = pages.pop(0)
+        if isinstance(page, Exception):
+            raise page
+        return page
+
+    model = ReadModel("https://x/notice.do", fetch, parse, restore)
+    assert model.latest() is None
+
+    for expected in (["a", "b"], ["a", "b"], ["a", "b"], ["c"]):
+        asyncio.run(model.refresh([LATEST]))
+        assert model.latest() == expected, "failures keep the old list"
+    assert model.stats()["failures"] == 2
+
+
+def test_read_model_export_load():
+    async def fetch(url, timeout):
+        return b"1,2" if "srCategoryId=3" in url else b"x"
+
+    publisher = ReadModel("https://x/notice.do", fetch, parse, restore)
+    assert asyncio.run(publisher.refresh([LATEST, 3])) == 2
+    exported = publisher.export()
+    assert asyncio.run(publisher.refresh([LATEST, 3])) == 0
+    assert publisher.export() == exported, "unchanged lists keep the snapshot"
+
+    worker = ReadModel("https://x/notice.do", None, None, restore)
+    assert worker.load(exported) == 2
+    assert worker.category(3) == ["1", "2"] and worker.latest() == ["x"]
+    assert worker.load(exported) == 0, "same snapshot is not restored again"
+    assert worker.cards(3, putDate=True) == (["1", "2"], [b"1@", b"2@"])
+    assert worker.cards(5) == (None, None)
+
+
+def test_read_model_ingest_survives_errors():
+    calls = []
+
+    async def fetch(url, timeout):
+        return b"x"
+
+    def flaky(html):
+        calls.append(html)
+        if len(calls) == 1:
+            raise ValueError("bad page")
+        return parse(html)
+
+    model = ReadModel(
+        "https://x/notice.do",
+        fetch,
+        flaky,
+        restore,
+        latestInterval=0.01,
+        categoryInterval=0,
+    )
+
+    async def ingest():
+        task = asyncio.ensure_future(model._ingest())
+        await asyncio.sleep(0.1)
+        task.cancel()
+
+    asyncio.run(ingest())
+    assert model.latest() == ["x"] and model.category(3) == ["x"]
+    stats = model.stats()
+    assert stats["failures"] == 1
+    assert stats["checked"]["latest"] <= stats["age"]["latest"], "fetched, not changed"
@@ -0,0 +1,77 @@
+import os
+from dataclasses import dataclass
+from datetime import date, timedelta
+
+os.environ.setdefault("KAKAO_DB", "sqlite://")  # retention 이 db_model 을 import 한다
+
+import db_model.crud
+import db_model.database
+import db_model.models
+from retention import RetentionManager
+
+
+@dataclass
+class Notice:
+    id: int
+    date: date
+    title: str = "t"
+    category: str = "학사"
+    link: str = "https://l"
+    writer: str = "w"
+
+
+def store(notices):
+    db_model.models.Base.metadata.create_all(bind=db_model.database.engine)
+    with db_model.database.SessionLocal() as db:
+        db.query(db_model.models.Notices).delete()
+        db.query(db_model.models.NoticesArchive).delete()
+        db.commit()
+        db_model.crud.create_notices(db=db, notices=notices)
+
+
+def stored():
+    with db_model.database.SessionLocal() as db:
+        hot = {notice.id for notice in db.query(db_model.models.Notices)}
+        archived = {notice.id for notice in db.query(db_model.models.NoticesArchive)}
+    return hot, archived
+
+
+def test_retention_moves_old_notices_in_batches(monkeypatch):
+    today = date(2021, 6, 1)
+    store(
+        [Notice(id, today - timedelta(days=40 + id)) for id in range(1, 6)]
+        + [Notice(id, today - timedelta(days=id - 10)) for id in range(10, 13)]
+    )
+    counts = []
+    archive = db_model.crud.archive_notices_before
+
+    def spy(db, cutoff, limit):
+        counts.append(archive(db, cutoff, limit))
+        return counts[-1]
+
+    monkeypatch.setattr(db_model.crud, "archive_notices_before", spy)
+    retention = RetentionManager(keep_days=30, batch=2, interval=0)
+
+    assert retention.run(today) == 5
+    assert counts == [2, 2, 1], "stops after a short batch"
+    assert stored() == ({10, 11, 12}, {1, 2, 3, 4, 5})
+    assert retention.stats()["last_cutoff"] == "2021-05-02"
+
+    counts.clear()
+    assert retention.run(today) == 0
+    assert counts == [0]
+
+
+def test_retention_maybe_run():
+    old = date.today() - timedelta(days=100)
+    store([Notice(1, old)])
+    assert RetentionManager(keep_days=0, interval=0).maybe_run() == 0, "0 days is off"
+    assert stored() == ({1}, set())
+
+    retention = RetentionManager(keep_days=30, interval=3600)
+    assert retention.maybe_run() == 1
+    with db_model.database.SessionLocal() as db:
+        db_model.crud.create_notices(db=db, notices=[Notice(2, old)])
+    assert retention.maybe_run() == 0, "waits for the interval"
+    assert stored() == ({2}, {1})
+    assert retention.stats()["runs"] == 1
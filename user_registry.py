@@ -0,0 +1,140 @@
+"""유저 id 레지스트리
+
+매 요청마다 users 테이블을 조회하는 대신, 시작할 때 전체 user_id 를 메모리에
+올려두고 처음 보는 유저만 모아서 백그라운드에서 한 번에 INSERT 한다.
+이미 있는 유저는 DB 에 가지 않는다.
+pre-fork 워커에서는 forwardTo() 로 DB 대신 supervisor 쪽 레지스트리에 넘긴다.
+
+환경 변수
+    KAKAO_USER_FLUSH  write-behind 주기(초) (default 2)
+    KAKAO_USER_BATCH  이만큼 쌓이면 주기 전에 flush (default 500)
+"""
+
+import os
+import threading
+
+import db_model.crud
+import db_model.database
+
+FLUSH_INTERVAL = float(os.environ.get("KAKAO_USER_FLUSH", 2.0))
+FLUSH_BATCH = int(os.environ.get("KAKAO_USER_BATCH", 500))
+
+
+class UserRegistry:
+    """
+    Methods
+    -------
+    preload() -> int
+    ensure(user_id) -> bool
+    start()
+    flush() -> int
+    forwardTo(send)
+    """
+
+    __slots__ = (
+        "interval",
+        "batch",
+        "_known",
+        "_pending",
+        "_lock",
+        "_wake",
+        "_thread",
+        "created",
+        "failures",
+        "_forward",
+    )
+
+    def __init__(self, interval=FLUSH_INTERVAL, batch=FLUSH_BATCH):
+        self.interval = interval
+        self.batch = batch
+        self._known = set()
+        self._pending = []
+        self._lock = threading.Lock()
+        self._wake = threading.Event()
+        self._thread = None
+        self.created = 0
+        self.failures = 0
+        self._forward = None  # send(user_id), pre-fork 워커
+
+    def preload(self):
+        """users 테이블의 user_id 를 전부 읽어온다. 실패해도 빈 채로 시작한다."""
+        if self._forward is not None:
+            return 0
+        try:
+            with db_model.database.SessionLocal() as db:
+                ids = db_model.crud.get_all_user_ids(db=db)
+        except Exception as e:
+            print("Couldn't preload users:", e)
+            return 0
+
+        with self._lock:
+            self._known.update(ids)
+        return len(ids)
+
+    def ensure(self, user_id):
+        """처음 보는 유저면 등록을 예약하고 True. (I/O 없음)"""
+        if user_id in self._known:
+            return False
+
+        with self._lock:
+            if user_id in self._known:
+                return False
+            self._known.add(user_id)
+            if self._forward is not None:
+                if not self._forward(user_id):
+                    self._known.discard(user_id)  # 못 넘겼으면 다음에 다시
+                return True
+            self._pending.append(user_id)
+            if len(self._pending) >= self.batch:
+                self._wake.set()
+        return True
+
+    def forwardTo(self, send):
+        """새 유저를 DB 에 쓰지 않고 send(user_id) -> bool 로 넘긴다. (preload/start X)"""
+        self._forward = send
+
+    def start(self):
+        if self._thread is not None or self._forward is not None:
+            return self._thread
+
+        def loop():
+            while True:
+                self._wake.wait(self.interval)
+                self._wake.clear()
+                self.flush()
+
+        self._thread = threading.Thread(
+            target=loop, name="user-write-behind", daemon=True
+        )
+        self._thread.start()
+        return self._thread
+
+    def flush(self):
+        with self._lock:
+            pending, self._pending = self._pending, []
+        if not pending:
+            return 0
+
+        try:
+            with db_model.database.SessionLocal() as db:
+                created = db_model.crud.create_users(db=db, user_ids=pending)
+        except Exception as e:
+            print("Couldn't save new users:", e)
+            self.failures += 1
+            with self._lock:
+                self._pending[:0] = pending  # 다음 flush 에서 다시
+            return 0
+
+        self.created += created
+        return created
+
+    def __len__(self):
+        return len(self._known)
+
+    def stats(self):
+        return {
+            "known": len(self._known),
+            "pending": len(self._pending),
+            "created": self.created,
+            "failures": self.failures,
+        }